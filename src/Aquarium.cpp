@@ -1,5 +1,6 @@
 #include "Aquarium.h"
 #include <cstdlib>
+#include <cstdio>
 
 
 string AquariumCreatureTypeToString(AquariumCreatureType t){
@@ -30,10 +31,11 @@ void PlayerCreature::setDirection(float dx, float dy) {
     normalize();
 }
 
-void PlayerCreature::move() {
-    m_x += m_dx * m_speed;
-    m_y += m_dy * m_speed;
-    this->bounce(nullptr);
+void PlayerCreature::move(const WorldBounds& world) {
+    float speed = m_speed * m_modifiers.speed;
+    m_x += m_dx * speed;
+    m_y += m_dy * speed;
+    this->bounce(world);
 }
 
 void PlayerCreature::reduceDamageDebounce() {
@@ -42,16 +44,9 @@ void PlayerCreature::reduceDamageDebounce() {
     }
 }
 
-void PlayerCreature::update() {
+void PlayerCreature::update(const WorldBounds& world) {
     this->reduceDamageDebounce();
-    if(m_speedBoostFrames > 0){
-        --m_speedBoostFrames;
-        if(m_speedBoostFrames == 0){
-            m_speed = m_base_speed;
-            m_isBoosted = false;
-        }
-    }
-    this->move();
+    this->move(world);
 }
 
 
@@ -60,9 +55,13 @@ void PlayerCreature::draw() const {
     ofLogVerbose() << "PlayerCreature at (" << m_x << ", " << m_y << ") with speed " << m_speed << std::endl;
     if (this->m_damage_debounce > 0) {
         ofSetColor(ofColor::red); // Flash red if in damage debounce
+    } else if (m_modifiers.invulnerable) {
+        ofSetColor(ofColor::gold);
+    } else {
+        ofSetColor(m_tint);
     }
     if (m_sprite) {
-        m_sprite->draw(m_x, m_y);
+        m_sprite->draw(m_x, m_y, m_flipped, m_modifiers.size);
     }
     ofSetColor(ofColor::white); // Reset color
 
@@ -73,6 +72,9 @@ void PlayerCreature::changeSpeed(int speed) {
 }
 
 void PlayerCreature::loseLife(int debounce) {
+    if (m_modifiers.invulnerable) {
+        return;
+    }
     if (m_damage_debounce <= 0) {
         if (m_lives > 0) this->m_lives -= 1;
         m_damage_debounce = debounce; // Set debounce frames
@@ -87,61 +89,65 @@ void PlayerCreature::loseLife(int debounce) {
 // NPCreature Implementation
 NPCreature::NPCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
 : Creature(x, y, speed, 30, 1, false, sprite) {
-    m_dx = (rand() % 3 - 1); // -1, 0, or 1
-    m_dy = (rand() % 3 - 1); // -1, 0, or 1
+    m_dx = (CreatureRandom() % 3 - 1); // -1, 0, or 1
+    m_dy = (CreatureRandom() % 3 - 1); // -1, 0, or 1
     normalize();
 
     m_creatureType = AquariumCreatureType::NPCreature;
+    m_kinematics = KinematicsKind::SWIM;
+}
+
+// the per object moves are the compatibility path, the aquarium moves these kinds in batches
+// with the same kinematics (see CreatureKinematics.h)
+template<class Kinematics>
+static void MoveWith(Creature& creature, const WorldBounds& world) {
+    KinematicState s = creature.getKinematicState();
+    Kinematics::step(s);
+    creature.setKinematicState(s);
+    if (Kinematics::kFlips) creature.setFlipped(Kinematics::facesLeft(s));
+    creature.bounce(world);
+}
+
+void NPCreature::makeBoss(float scale) {
+    m_bossScale = std::max(1.0f, scale);
+    m_collisionRadius *= m_bossScale;
+    m_value = int(std::ceil(m_value * m_bossScale * m_bossScale)); // worth what it would take to eat by area
 }
 
-void NPCreature::move() {
+void NPCreature::move(const WorldBounds& world) {
     // Simple AI movement logic (random direction)
-    m_x += m_dx * m_speed;
-    m_y += m_dy * m_speed;
-    if(m_dx < 0 ){
-        this->m_sprite->setFlipped(true);
-    }else {
-        this->m_sprite->setFlipped(false);
-    }
-    bounce(nullptr);
+    MoveWith<SwimKinematics>(*this, world);
 }
 
 void NPCreature::draw() const {
     ofLogVerbose() << "NPCreature at (" << m_x << ", " << m_y << ") with speed " << m_speed << std::endl;
     ofSetColor(ofColor::white);
     if (m_sprite) {
-        m_sprite->draw(m_x, m_y);
+        m_sprite->draw(m_x, m_y, m_flipped);
     }
 }
 
 
 BiggerFish::BiggerFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
 : NPCreature(x, y, speed, sprite) {
-    m_dx = (rand() % 3 - 1);
-    m_dy = (rand() % 3 - 1);
+    m_dx = (CreatureRandom() % 3 - 1);
+    m_dy = (CreatureRandom() % 3 - 1);
     normalize();
 
     setCollisionRadius(60); // Bigger fish have a larger collision radius
     m_value = 5; // Bigger fish have a higher value
     m_creatureType = AquariumCreatureType::BiggerFish;
+    m_kinematics = KinematicsKind::CRUISE;
 }
 
-void BiggerFish::move() {
-    // Bigger fish might move slower or have different logic
-    m_x += m_dx * (m_speed * 0.5); // Moves at half speed
-    m_y += m_dy * (m_speed * 0.5);
-    if(m_dx < 0 ){
-        this->m_sprite->setFlipped(true);
-    }else {
-        this->m_sprite->setFlipped(false);
-    }
-
-    bounce(nullptr);
+void BiggerFish::move(const WorldBounds& world) {
+    // Bigger fish move at half speed
+    MoveWith<CruiseKinematics>(*this, world);
 }
 
 void BiggerFish::draw() const {
     ofLogVerbose() << "BiggerFish at (" << m_x << ", " << m_y << ") with speed " << m_speed << std::endl;
-    this->m_sprite->draw(this->m_x, this->m_y);
+    this->m_sprite->draw(this->m_x, this->m_y, this->m_flipped);
 }
 
 JellyFish::JellyFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
@@ -149,68 +155,113 @@ JellyFish::JellyFish(float x, float y, int speed, std::shared_ptr<GameSprite> sp
     m_creatureType = AquariumCreatureType::JellyFish;
     setCollisionRadius(28);
     m_value = 2;
+    m_kinematics = KinematicsKind::DRIFT;
+    m_motionPattern = MotionTables::kBob;
 }
 
-void JellyFish::move(){
-    t += 0.05f;
-    m_x += (m_dx == 0 ? 1 : m_dx) * (m_speed * 0.4f);
-    m_y += std::sin(t) * 1.8f;
-    bounce(nullptr);
+void JellyFish::move(const WorldBounds& world){
+    MoveWith<DriftKinematics>(*this, world);
 }
 
 void JellyFish::draw() const{
-    m_sprite->draw(m_x, m_y);
+    m_sprite->draw(m_x, m_y, m_flipped);
 }
 
 FastFish::FastFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite )
 :NPCreature(x, y, std::max(speed, 6), sprite){
     m_creatureType = AquariumCreatureType::FastFish;
+    m_dy = 0; // darts sideways, only schooling and a player's magnet ever give it a vertical heading
     setCollisionRadius(24);
     m_value = 3;
+    m_kinematics = KinematicsKind::DART;
+    m_motionPattern = MotionTables::kZigZag;
 }
 
-void FastFish::move(){
-    ++step;
-    float zig = (step % 30 < 15) ? 1.0f : -1.0f;
-    m_x += (m_dx == 0 ? 1 : m_dx) * (m_speed * 1.2f);
-    m_y += zig * 0.9f;
-    if(m_dx < 0 ){
-        this->m_sprite->setFlipped(false);
-    }else {
-        this->m_sprite->setFlipped(true);
-    }
-    bounce(nullptr);
+void FastFish::move(const WorldBounds& world){
+    MoveWith<DartKinematics>(*this, world);
 }
 
 void FastFish::draw() const{
-    m_sprite->draw(m_x, m_y);
+    m_sprite->draw(m_x, m_y, m_flipped);
+}
+
+
+PowerUp::PowerUp(float x, float y, std::shared_ptr<GameSprite> sprite, const EffectGrant& grant)
+: NPCreature(x, y, 2, sprite), m_grant(grant) {
+    setCollisionRadius(18);
+    m_creatureType = AquariumCreatureType::PowerUp;
+}
+
+EffectGrant PowerUp::GrantFor(EffectKind kind) {
+    // roughly equal value, the weaker the effect the longer it lasts
+    static const EffectGrant kGrants[] = {
+        {EffectKind::SPEED, 2.0f, 300},
+        {EffectKind::SIZE, 1.5f, 420},
+        {EffectKind::INVULNERABLE, 1.0f, 300},
+        {EffectKind::MAGNET, 250.0f, 480},
+        {EffectKind::SCORE, 2.0f, 600},
+    };
+    return kGrants[int(kind) % int(EffectKind::COUNT)];
+}
+
+EffectGrant PowerUp::RandomGrant() {
+    return GrantFor(EffectKind(CreatureRandom() % int(EffectKind::COUNT)));
 }
 
 
 // AquariumSpriteManager
 AquariumSpriteManager::AquariumSpriteManager(){
-    this->m_npc_fish = std::make_shared<GameSprite>("base-fish.png", 70,70);
-    this->m_big_fish = std::make_shared<GameSprite>("bigger-fish.png", 120, 120);
-    this->m_jelly_fish = std::make_shared<GameSprite>("jelly-fish.png", 80, 80);
-    this->m_fast_fish = std::make_shared<GameSprite>("fast-fish.png", 70, 70);
-    this->m_powerup = std::make_shared<GameSprite>("power-up.png", 40, 40);
+    int npc = GetSpriteSide(AquariumCreatureType::NPCreature);
+    int big = GetSpriteSide(AquariumCreatureType::BiggerFish);
+    int jelly = GetSpriteSide(AquariumCreatureType::JellyFish);
+    int fast = GetSpriteSide(AquariumCreatureType::FastFish);
+    int powerup = GetSpriteSide(AquariumCreatureType::PowerUp);
+    this->m_npc_fish = MakeTracked<MemorySubsystem::SPRITES, GameSprite>("base-fish.png", npc, npc);
+    this->m_big_fish = MakeTracked<MemorySubsystem::SPRITES, GameSprite>("bigger-fish.png", big, big);
+    this->m_jelly_fish = MakeTracked<MemorySubsystem::SPRITES, GameSprite>("jelly-fish.png", jelly, jelly);
+    this->m_fast_fish = MakeTracked<MemorySubsystem::SPRITES, GameSprite>("fast-fish.png", fast, fast);
+    this->m_powerup = MakeTracked<MemorySubsystem::SPRITES, GameSprite>("power-up.png", powerup, powerup);
+
+    // sprite ids in the atlas are the creature types
+    std::vector<SpriteSource> sources;
+    for(int t = 0; t < kAquariumCreatureTypeCount; ++t){
+        auto type = static_cast<AquariumCreatureType>(t);
+        sources.push_back(SpriteSource{&this->GetSprite(type)->getImage(), GetSpriteSide(type), GetSpriteSide(type), GetAnimation(type)});
+    }
+    this->m_atlas.Build(sources);
+}
 
+int AquariumSpriteManager::GetSpriteSide(AquariumCreatureType t){
+    switch(t){
+        case AquariumCreatureType::BiggerFish: return 120;
+        case AquariumCreatureType::JellyFish: return 80;
+        case AquariumCreatureType::PowerUp: return 40;
+        case AquariumCreatureType::NPCreature:
+        case AquariumCreatureType::FastFish:
+        default: return 70;
+    }
+}
 
+const SpriteAnimation& AquariumSpriteManager::GetAnimation(AquariumCreatureType t){
+    // motion, frames, ticks per frame
+    static const SpriteAnimation kAnimations[kAquariumCreatureTypeCount] = {
+        {SpriteMotion::FINS, 4, 8},   // NPCreature
+        {SpriteMotion::FINS, 4, 12},  // BiggerFish, slow strokes for a big tail
+        {SpriteMotion::PULSE, 6, 10}, // JellyFish
+        {SpriteMotion::FINS, 4, 4},   // FastFish
+        {SpriteMotion::PULSE, 4, 8},  // PowerUp
+    };
+    return kAnimations[int(t)];
 }
 
+// one sprite per type shared by every creature of it, facing and animation are kept by the creature
 std::shared_ptr<GameSprite> AquariumSpriteManager::GetSprite(AquariumCreatureType t){
     switch(t){
-        case AquariumCreatureType::BiggerFish:
-            return std::make_shared<GameSprite>(*this->m_big_fish);
-            
-        case AquariumCreatureType::NPCreature:
-            return std::make_shared<GameSprite>(*this->m_npc_fish);
-        case AquariumCreatureType::JellyFish:
-            return std::make_shared<GameSprite>(*this->m_jelly_fish);
-        case AquariumCreatureType::FastFish:
-            return std::make_shared<GameSprite>(*this->m_fast_fish);
-        case AquariumCreatureType::PowerUp:
-            return std::make_shared<GameSprite>(*this->m_powerup);
+        case AquariumCreatureType::BiggerFish: return this->m_big_fish;
+        case AquariumCreatureType::NPCreature: return this->m_npc_fish;
+        case AquariumCreatureType::JellyFish: return this->m_jelly_fish;
+        case AquariumCreatureType::FastFish: return this->m_fast_fish;
+        case AquariumCreatureType::PowerUp: return this->m_powerup;
         default:
             return nullptr;
     }
@@ -219,15 +270,73 @@ std::shared_ptr<GameSprite> AquariumSpriteManager::GetSprite(AquariumCreatureTyp
 
 // Aquarium Implementation
 Aquarium::Aquarium(int width, int height, std::shared_ptr<AquariumSpriteManager> spriteManager)
-    : m_width(width), m_height(height) {
+    : m_bounds{float(width), float(height), 20.0f} {
         m_sprite_manager =  spriteManager;
+        m_broadphase = MakeBroadphase(BroadphaseKind::BRUTE_FORCE);
+
+        // only the small fish school by default, the rest ignore it even when enabled
+        SchoolingWeights baseFish;
+        baseFish.enabled = true;
+        baseFish.separation = 0.15f;
+        baseFish.alignment = 0.12f;
+        baseFish.cohesion = 0.08f;
+        baseFish.neighborRadius = 90.0f;
+        this->setSchoolingWeights(AquariumCreatureType::NPCreature, baseFish);
+
+        SchoolingWeights fastFish = baseFish;
+        fastFish.alignment = 0.2f;
+        fastFish.cohesion = 0.04f;
+        fastFish.neighborRadius = 120.0f;
+        this->setSchoolingWeights(AquariumCreatureType::FastFish, fastFish);
+
+        // the food web: bigger fish chase the small ones, jellyfish sting fast fish that bump into them
+        PredatorDiet bigFish;
+        bigFish.preyMask = 1 << int(AquariumCreatureType::NPCreature);
+        bigFish.huntRadius = 300.0f;
+        bigFish.chases = true;
+        bigFish.turnRate = 0.15f;
+        this->setPredatorDiet(AquariumCreatureType::BiggerFish, bigFish);
+
+        PredatorDiet jellyFish;
+        jellyFish.preyMask = 1 << int(AquariumCreatureType::FastFish);
+        jellyFish.huntRadius = 60.0f; // its own radius plus a fast fish's, touching is all it does
+        jellyFish.stings = true;
+        this->setPredatorDiet(AquariumCreatureType::JellyFish, jellyFish);
     }
 
+void Aquarium::setPredatorDiet(AquariumCreatureType predator, const PredatorDiet& diet){
+    m_diets[static_cast<int>(predator)] = diet;
+}
+
+const PredatorDiet& Aquarium::getPredatorDiet(AquariumCreatureType predator) const {
+    return m_diets[static_cast<int>(predator)];
+}
+
+void Aquarium::setSchoolingWeights(AquariumCreatureType type, const SchoolingWeights& weights){
+    m_schoolingWeights[static_cast<int>(type)] = weights;
+}
+
+const SchoolingWeights& Aquarium::getSchoolingWeights(AquariumCreatureType type) const {
+    return m_schoolingWeights[static_cast<int>(type)];
+}
+
+void Aquarium::setBroadphase(BroadphaseKind kind){
+    if(m_broadphase->GetKind() == kind){return;} // keep the sorted state of the current one
+    m_broadphase = MakeBroadphase(kind);
+    ofLogNotice() << "broadphase set to " << BroadphaseKindToString(kind) << std::endl;
+}
+
 
 
 void Aquarium::addCreature(std::shared_ptr<Creature> creature) {
-    creature->setBounds(m_width - 20, m_height - 20);
+    // everything in the tank is read back as an NPCreature, players and the like stay out
+    if (creature == nullptr || dynamic_cast<NPCreature*>(creature.get()) == nullptr) {
+        ofLogError() << "only NPCreatures go in the aquarium" << std::endl;
+        return;
+    }
     m_creatures.push_back(creature);
+    this->batchOf(*creature).add(creature.get());
+    m_spatialIndexDirty = true;
 }
 
 void Aquarium::addAquariumLevel(std::shared_ptr<AquariumLevel> level){
@@ -235,25 +344,222 @@ void Aquarium::addAquariumLevel(std::shared_ptr<AquariumLevel> level){
     this->m_aquariumlevels.push_back(level);
 }
 
+std::shared_ptr<AquariumLevel> Aquarium::getActiveLevel() const {
+    if(this->m_aquariumlevels.empty()){return nullptr;}
+    return this->m_aquariumlevels.at(this->currentLevel % this->m_aquariumlevels.size());
+}
+
 void Aquarium::update() {
-    for (auto& creature : m_creatures) {
-        creature->move();
+    // scripts first, so whatever they spawn or change takes part in this tick
+    m_scripts.Tick();
+    m_effects.Tick();
+    if (m_schoolingEnabled) {
+        this->applySchooling();
+    }
+    // far away creatures take one real step every few ticks and repeat it for the skipped ones,
+    // staggered by batch slot so they do not all land on the same tick
+    ++m_tick;
+    ++m_stats.ticks;
+    // each kind is stepped as one batch without virtual calls
+    auto schedule = [this](const Creature& creature, int slot) {
+        bool near = !m_hasActiveArea || m_activeArea.inside(creature.getX(), creature.getY());
+        if (near || m_farUpdateInterval <= 1) return 0;
+        if ((m_tick + slot) % m_farUpdateInterval != 0) return -1;
+        return m_farUpdateInterval - 1;
+    };
+    m_batches[int(KinematicsKind::SWIM)].run<SwimKinematics>(m_bounds, schedule);
+    m_batches[int(KinematicsKind::CRUISE)].run<CruiseKinematics>(m_bounds, schedule);
+    m_batches[int(KinematicsKind::DRIFT)].run<DriftKinematics>(m_bounds, schedule);
+    m_batches[int(KinematicsKind::DART)].run<DartKinematics>(m_bounds, schedule);
+    m_batches[int(KinematicsKind::CUSTOM)].runVirtual(m_bounds, schedule);
+    m_spatialIndexDirty = true;
+    this->animate();
+    m_lastEcosystemUs = 0;
+    if (m_ecosystemEnabled) {
+        uint64_t ecosystemStart = FrameClockMicros();
+        this->applyEcosystem();
+        m_lastEcosystemUs = FrameClockMicros() - ecosystemStart;
     }
     this->Repopulate();
 }
 
-void Aquarium::draw() const {
+// every predator looks up the few nearest creatures it may eat, takes the closest one no other
+// predator went for this tick, eats it if they touch and otherwise turns towards it
+// the eaten are removed together at the end and counted off their level like any other meal
+void Aquarium::applyEcosystem() {
+    m_lastEcosystemKills = 0;
+    int count = m_creatures.size();
+    if (count == 0) {return;}
+    const SpatialGrid& grid = this->getSpatialIndex();
+
+    m_ecoType.resize(count);
+    m_ecoValue.resize(count);
+    m_ecoEaten.assign(count, 0);
+    m_ecoClaimed.assign(count, 0);
+    bool anyPredator = false;
+    for (int i = 0; i < count; ++i) {
+        m_ecoType[i] = uint8_t(std::static_pointer_cast<NPCreature>(m_creatures[i])->GetType());
+        m_ecoValue[i] = m_creatures[i]->getValue();
+        anyPredator = anyPredator || m_diets[m_ecoType[i]].preyMask != 0;
+    }
+    if (!anyPredator) {return;}
+
+    const int k = 4;
+    int nearest[k];
+    float nearestDistSq[k];
+    for (int i = 0; i < count; ++i) {
+        const PredatorDiet& diet = m_diets[m_ecoType[i]];
+        if (diet.preyMask == 0 || m_ecoEaten[i]) continue;
+        Creature& predator = *m_creatures[i];
+        int rank = m_ecoValue[i];
+        int found = grid.KNearest(predator.getX(), predator.getY(), diet.huntRadius, k, [&](int j){
+            return j != i && !m_ecoEaten[j] && (diet.preyMask >> m_ecoType[j] & 1)
+                && (diet.stings || m_ecoValue[j] < rank);
+        }, nearest, nearestDistSq);
+        if (found == 0) continue;
+
+        // spread a pack over the school instead of all of them diving for the same fish
+        int pick = 0;
+        while (pick < found && m_ecoClaimed[nearest[pick]]) ++pick;
+        if (pick == found) pick = 0;
+        int prey = nearest[pick];
+        m_ecoClaimed[prey] = 1;
+
+        float reach = predator.getCollisionRadius() + m_creatures[prey]->getCollisionRadius();
+        if (nearestDistSq[pick] < reach * reach) {
+            m_ecoEaten[prey] = 1;
+            ++m_lastEcosystemKills;
+        } else if (diet.chases) {
+            float dist = std::sqrt(nearestDistSq[pick]);
+            float toX = (m_creatures[prey]->getX() - predator.getX()) / dist;
+            float toY = (m_creatures[prey]->getY() - predator.getY()) / dist;
+            predator.setVelocity(predator.getDx() * (1 - diet.turnRate) + toX * diet.turnRate,
+                                 predator.getDy() * (1 - diet.turnRate) + toY * diet.turnRate);
+            predator.normalize();
+        }
+    }
+    if (m_lastEcosystemKills == 0) {return;}
+
+    // eaten fish score nothing for the player, but their level still has to respawn them
+    std::shared_ptr<AquariumLevel> level = this->getActiveLevel();
+    int kept = 0;
+    for (int i = 0; i < count; ++i) {
+        if (m_ecoEaten[i]) {
+            if (std::static_pointer_cast<NPCreature>(m_creatures[i])->isBoss()) {
+                m_scripts.Raise(ScriptSignal::BOSS_DEFEATED);
+            } else if (level) {
+                level->ConsumePopulation(AquariumCreatureType(m_ecoType[i]), 0);
+            }
+            m_scripts.Raise(ScriptSignal::CREATURE_EATEN);
+            m_effects.Clear(*m_creatures[i]);
+            this->batchOf(*m_creatures[i]).remove(m_creatures[i].get());
+            continue;
+        }
+        if (kept != i) m_creatures[kept] = std::move(m_creatures[i]);
+        ++kept;
+    }
+    m_creatures.resize(kept);
+    m_spatialIndexDirty = true;
+    m_stats.removed += m_lastEcosystemKills;
+    m_stats.preyEaten += m_lastEcosystemKills;
+}
+
+void Aquarium::setActiveArea(float x, float y, float w, float h) {
+    m_activeArea.set(x, y, w, h);
+    m_hasActiveArea = true;
+}
+
+// steering is computed for everyone first and applied after, so the result does not depend on creature order
+void Aquarium::applySchooling() {
+    int count = m_creatures.size();
+    m_schoolDx.resize(count);
+    m_schoolDy.resize(count);
+    m_schoolType.resize(count);
+    for (int i = 0; i < count; ++i) {
+        m_schoolDx[i] = m_creatures[i]->getDx();
+        m_schoolDy[i] = m_creatures[i]->getDy();
+        m_schoolType[i] = static_cast<int>(std::static_pointer_cast<NPCreature>(m_creatures[i])->GetType());
+    }
+
+    const SpatialGrid& index = this->getSpatialIndex();
+    std::vector<float>& steerX = m_schoolSteerX;
+    std::vector<float>& steerY = m_schoolSteerY;
+    steerX.assign(count, 0.0f);
+    steerY.assign(count, 0.0f);
+    for (int i = 0; i < count; ++i) {
+        const SchoolingWeights& w = m_schoolingWeights[m_schoolType[i]];
+        if (!w.enabled || w.neighborRadius <= 0) continue;
+
+        float sepX = 0, sepY = 0, headX = 0, headY = 0, midX = 0, midY = 0;
+        int neighbors = 0;
+        index.ForEachCenterWithin(m_creatures[i]->getX(), m_creatures[i]->getY(), w.neighborRadius,
+            [&](int j, float dx, float dy, float distSq) {
+                if (j == i || m_schoolType[j] != m_schoolType[i]) return;
+                if (distSq > 0) {
+                    sepX -= dx / distSq;
+                    sepY -= dy / distSq;
+                }
+                headX += m_schoolDx[j];
+                headY += m_schoolDy[j];
+                midX += dx;
+                midY += dy;
+                ++neighbors;
+            });
+        if (neighbors == 0) continue;
+
+        // separation falls off with distance, the other two are averages over the school
+        steerX[i] = w.separation * sepX * w.neighborRadius
+                  + w.alignment * (headX / neighbors - m_schoolDx[i])
+                  + w.cohesion * (midX / neighbors) / w.neighborRadius;
+        steerY[i] = w.separation * sepY * w.neighborRadius
+                  + w.alignment * (headY / neighbors - m_schoolDy[i])
+                  + w.cohesion * (midY / neighbors) / w.neighborRadius;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (steerX[i] == 0 && steerY[i] == 0) continue;
+        m_creatures[i]->setVelocity(m_schoolDx[i] + steerX[i], m_schoolDy[i] + steerY[i]);
+        m_creatures[i]->normalize();
+    }
+}
+
+// every creature's animation steps here in one pass, drawing only reads the frame it is on
+void Aquarium::animate() {
     for (const auto& creature : m_creatures) {
-        creature->draw();
+        const SpriteAnimation& animation =
+            AquariumSpriteManager::GetAnimation(std::static_pointer_cast<NPCreature>(creature)->GetType());
+        creature->advanceAnimation(animation.frames, animation.ticksPerFrame);
     }
 }
 
-void Aquarium::setBounds(int w, int h){
-    m_width = w;
-    m_height = h;
-    for(auto& c : m_creatures){
-        c->setBounds(m_width - 20, m_height - 20);
+void Aquarium::draw(const GameCamera& camera) const {
+    // sprites hang down and right from the creature position, the margin keeps the big ones from popping
+    const float margin = 128.0f;
+    m_lastDrawCount = 0;
+    SpriteAtlas* atlas = m_sprite_manager ? &m_sprite_manager->GetAtlas() : nullptr;
+    if (atlas == nullptr || !atlas->IsBuilt()) {
+        for (const auto& creature : m_creatures) {
+            if (!camera.isVisible(creature->getX(), creature->getY(), margin)) continue;
+            creature->draw();
+            ++m_lastDrawCount;
+        }
+        return;
+    }
+    // everything on screen goes into one mesh over the atlas and is drawn with a single call
+    atlas->Begin();
+    for (const auto& creature : m_creatures) {
+        if (!camera.isVisible(creature->getX(), creature->getY(), margin)) continue;
+        const NPCreature& npc = static_cast<const NPCreature&>(*creature);
+        atlas->Add(int(npc.GetType()), npc.getAnimationFrame(), npc.getX(), npc.getY(), npc.isFlipped(), npc.getBossScale());
+        ++m_lastDrawCount;
     }
+    atlas->Draw();
+}
+
+// every creature reads the walls from here when it moves, so nothing else needs to change
+void Aquarium::setBounds(int w, int h){
+    m_bounds.width = w;
+    m_bounds.height = h;
 }
 
 
@@ -261,15 +567,94 @@ void Aquarium::removeCreature(std::shared_ptr<Creature> creature) {
     auto it = std::find(m_creatures.begin(), m_creatures.end(), creature);
     if (it != m_creatures.end()) {
         ofLogVerbose() << "removing creature " << endl;
-        int selectLvl = this->currentLevel % this->m_aquariumlevels.size();
+        // a tank without levels still lets creatures go, there is just no population to count them off
+        std::shared_ptr<AquariumLevel> level = this->getActiveLevel();
         auto npcCreature = std::static_pointer_cast<NPCreature>(creature);
-        this->m_aquariumlevels.at(selectLvl)->ConsumePopulation(npcCreature->GetType(), npcCreature->getValue());
+        if (npcCreature->isBoss()) {
+            // not part of the population, nothing to respawn
+            if (level) level->AddScore(npcCreature->getValue());
+            m_scripts.Raise(ScriptSignal::BOSS_DEFEATED);
+        } else if (level) {
+            level->ConsumePopulation(npcCreature->GetType(), npcCreature->getValue());
+        }
+        m_scripts.Raise(ScriptSignal::CREATURE_EATEN);
+        m_effects.Clear(*creature);
+        this->batchOf(*creature).remove(creature.get());
         m_creatures.erase(it);
+        m_spatialIndexDirty = true;
+        ++m_stats.removed;
+    }
+}
+
+size_t Aquarium::getBatchedCount() const {
+    size_t count = 0;
+    for (const KinematicBatch& batch : m_batches) {
+        count += batch.size();
+    }
+    return count;
+}
+
+void Aquarium::CountByType(std::array<int, kAquariumCreatureTypeCount>& counts) const {
+    counts.fill(0);
+    for (const auto& creature : m_creatures) {
+        ++counts[int(std::static_pointer_cast<NPCreature>(creature)->GetType())];
     }
 }
 
 void Aquarium::clearCreatures() {
+    for (const auto& creature : m_creatures) {
+        m_effects.Clear(*creature);
+    }
+    for (KinematicBatch& batch : m_batches) {
+        batch.clear();
+    }
     m_creatures.clear();
+    m_regionStore.Clear(); // a new level starts from an empty tank, on disk too
+    m_spatialIndexDirty = true;
+}
+
+void Aquarium::markCollisionCheckpoint() {
+    for (auto& creature : m_creatures) {
+        creature->markCollisionCheckpoint();
+    }
+    m_spatialIndexDirty = true; // collision response may have nudged creatures since the last build
+}
+
+int Aquarium::ResolveContacts(int iterations) {
+    // the broadphase picks which pairs are worth testing, powerups float through everything
+    m_contactSolver.Clear();
+    m_broadphase->ForEachCandidatePair(m_creatures, [this](int i, int j){
+        const std::shared_ptr<Creature>& a = m_creatures[i];
+        const std::shared_ptr<Creature>& b = m_creatures[j];
+        if(std::static_pointer_cast<NPCreature>(a)->GetType() == AquariumCreatureType::PowerUp) return false;
+        if(std::static_pointer_cast<NPCreature>(b)->GetType() == AquariumCreatureType::PowerUp) return false;
+        if(checkSweptCollision(a, b)) m_contactSolver.AddContact(i, j);
+        return false;
+    });
+    int contacts = m_contactSolver.GetContactCount();
+    m_stats.contacts += contacts;
+    if (contacts > 0) {
+        m_contactSolver.Solve(m_creatures, iterations, m_bounds);
+        m_spatialIndexDirty = true;
+    }
+    return contacts;
+}
+
+const SpatialGrid& Aquarium::getSpatialIndex() {
+    if (m_spatialIndexDirty) {
+        // cells about the size of the biggest fish keep most queries to a 3x3 block
+        m_spatialIndex.Build(m_creatures, 128.0f);
+        m_spatialIndexDirty = false;
+    }
+    return m_spatialIndex;
+}
+
+void Aquarium::QueryRadius(float x, float y, float radius, std::vector<std::shared_ptr<Creature>>& out) {
+    out.clear();
+    this->getSpatialIndex().QueryRadius(x, y, radius, m_queryScratch);
+    for (int i : m_queryScratch) {
+        out.push_back(m_creatures[i]);
+    }
 }
 
 std::shared_ptr<Creature> Aquarium::getCreatureAt(int index) {
@@ -281,38 +666,179 @@ std::shared_ptr<Creature> Aquarium::getCreatureAt(int index) {
 
 
 
-void Aquarium::SpawnCreature(AquariumCreatureType type) {
-    int x = rand() % this->getWidth();
-    int y = rand() % this->getHeight();
-    int randomSpeed = 1 + rand() % 5; // Speed between 1 and 10
-
+std::shared_ptr<NPCreature> Aquarium::MakeCreature(AquariumCreatureType type, float x, float y, int speed) {
+    std::shared_ptr<GameSprite> sprite = this->m_sprite_manager ? this->m_sprite_manager->GetSprite(type) : nullptr;
     switch (type) {
         case AquariumCreatureType::NPCreature:
-            this->addCreature(std::make_shared<NPCreature>(x, y, randomSpeed, this->m_sprite_manager->GetSprite(AquariumCreatureType::NPCreature)));
-            break;
+            return MakeTracked<MemorySubsystem::CREATURES, NPCreature>(x, y, speed, sprite);
         case AquariumCreatureType::BiggerFish:
-            this->addCreature(std::make_shared<BiggerFish>(x, y, randomSpeed, this->m_sprite_manager->GetSprite(AquariumCreatureType::BiggerFish)));
-            break;
-         case AquariumCreatureType::JellyFish:
-            this->addCreature(std::make_shared<JellyFish>(x, y, randomSpeed, this->m_sprite_manager->GetSprite(AquariumCreatureType::JellyFish)));
-            break;
-         case AquariumCreatureType::FastFish:
-            this->addCreature(std::make_shared<FastFish>(x, y, randomSpeed, this->m_sprite_manager->GetSprite(AquariumCreatureType::FastFish)));
-            break;
-         case AquariumCreatureType::PowerUp:
-            {
-                auto p = std::make_shared<NPCreature>(x, y, 2, this->m_sprite_manager->GetSprite(AquariumCreatureType::PowerUp));
-                p->setCollisionRadius(18);
-                p->setCreatureType(AquariumCreatureType::PowerUp);
-                p->setSpeed(2);
-                this->addCreature(p);
-            }
-            break;
+            return MakeTracked<MemorySubsystem::CREATURES, BiggerFish>(x, y, speed, sprite);
+        case AquariumCreatureType::JellyFish:
+            return MakeTracked<MemorySubsystem::CREATURES, JellyFish>(x, y, speed, sprite);
+        case AquariumCreatureType::FastFish:
+            return MakeTracked<MemorySubsystem::CREATURES, FastFish>(x, y, speed, sprite);
+        case AquariumCreatureType::PowerUp:
+            return MakeTracked<MemorySubsystem::CREATURES, PowerUp>(x, y, sprite, PowerUp::RandomGrant());
         default:
             ofLogError() << "Unknown creature type to spawn!";
-            break;
+            return nullptr;
     }
+}
 
+std::shared_ptr<NPCreature> Aquarium::SpawnBoss(AquariumCreatureType type, float scale) {
+    ofRectangle area = this->getSpawnArea();
+    std::shared_ptr<NPCreature> boss = this->MakeCreature(type, area.x, area.y, 1 + CreatureRandom() % 5);
+    if (!boss) {return nullptr;}
+    // grown before it is placed, so the spot it gets has room for all of it
+    boss->makeBoss(scale);
+    this->beginSpawns(area);
+    if (!this->placeSpawn(boss, true)) {
+        ofLogVerbose() << "no room for a " << AquariumCreatureTypeToString(type) << " boss yet" << std::endl;
+        return nullptr;
+    }
+    ofLogNotice() << "a " << AquariumCreatureTypeToString(type) << " boss appeared" << std::endl;
+    return boss;
+}
+
+void Aquarium::SpawnCreature(AquariumCreatureType type) {
+    this->SpawnCreatures({type});
+}
+
+void Aquarium::SpawnCreatures(const std::vector<AquariumCreatureType>& types) {
+    if (types.empty()) {return;}
+    ofRectangle area = this->getSpawnArea();
+    this->beginSpawns(area);
+    for (AquariumCreatureType type : types) {
+        int randomSpeed = 1 + CreatureRandom() % 5; // Speed between 1 and 10
+        // made first so the placer knows how much room it needs
+        std::shared_ptr<NPCreature> creature = this->MakeCreature(type, area.x, area.y, randomSpeed);
+        if (!creature) {continue;}
+        this->placeSpawn(creature, false);
+    }
+    if (m_spawnPlacer.GetFallbackCount() > 0) {
+        ofLogVerbose() << m_spawnPlacer.GetFallbackCount() << " of " << types.size()
+                       << " spawns found no clear spot" << std::endl;
+    }
+}
+
+void Aquarium::beginSpawns(const ofRectangle& area) {
+    // the index is only read while placing, adding the batch marks it dirty for the next query
+    const SpatialGrid& existing = this->getSpatialIndex();
+    m_spawnPlacer.Begin(area, &existing, 128.0f);
+    for (const SpawnSafeZone& zone : m_spawnSafeZones) {
+        m_spawnPlacer.AddSafeZone(zone);
+    }
+}
+
+bool Aquarium::placeSpawn(const std::shared_ptr<NPCreature>& creature, bool requireClear) {
+    float x, y;
+    bool clear = m_spawnPlacer.Place(creature->getCollisionRadius(), m_spawnGap, x, y);
+    if (!clear && requireClear) {return false;}
+    creature->setPosition(x, y);
+    // start somewhere in the cycle so a school does not beat its fins in lockstep
+    creature->setAnimationFrame((int(x) + int(y)) % AquariumSpriteManager::GetAnimation(creature->GetType()).frames);
+    this->addCreature(creature);
+    ++m_stats.spawned;
+    return clear;
+}
+
+// with streaming on, new fish go where the player can meet them instead of straight to disk
+ofRectangle Aquarium::getSpawnArea() const {
+    if (!m_regionStore.IsOpen()) {
+        return ofRectangle(0, 0, m_bounds.width, m_bounds.height);
+    }
+    float size = m_regionStore.GetRegionSize();
+    float x0 = std::max(0.0f, (m_focusRegionX - m_residentRadius) * size);
+    float y0 = std::max(0.0f, (m_focusRegionY - m_residentRadius) * size);
+    float x1 = std::min(m_bounds.width, (m_focusRegionX + m_residentRadius + 1) * size);
+    float y1 = std::min(m_bounds.height, (m_focusRegionY + m_residentRadius + 1) * size);
+    if (x1 <= x0 || y1 <= y0) {
+        return ofRectangle(0, 0, m_bounds.width, m_bounds.height);
+    }
+    return ofRectangle(x0, y0, x1 - x0, y1 - y0);
+}
+
+void Aquarium::enableRegionStreaming(const std::string& directory, float regionSize, int residentRadius) {
+    m_regionStore.Open(directory, regionSize);
+    m_residentRadius = std::max(0, residentRadius);
+    m_streamCountdown = 0;
+}
+
+// regions within m_residentRadius of the focus stay in memory, past one more ring they go to disk
+// the ring in between is slack so a player on a region border does not make it thrash
+void Aquarium::StreamRegions(float focusX, float focusY) {
+    if (!m_regionStore.IsOpen()) {return;}
+    int fcx, fcy;
+    m_regionStore.RegionOf(focusX, focusY, fcx, fcy);
+    bool focusMoved = fcx != m_focusRegionX || fcy != m_focusRegionY;
+    // even without the player moving, fish wander across the eviction ring now and then
+    if (!focusMoved && --m_streamCountdown > 0) {return;}
+    m_streamCountdown = 60;
+    m_focusRegionX = fcx;
+    m_focusRegionY = fcy;
+
+    std::unordered_map<long long, std::vector<RegionCreatureRecord>> evicted;
+    size_t kept = 0;
+    for (size_t i = 0; i < m_creatures.size(); ++i) {
+        std::shared_ptr<Creature>& creature = m_creatures[i];
+        int cx, cy;
+        m_regionStore.RegionOf(creature->getX(), creature->getY(), cx, cy);
+        // bosses stay in memory, the records on disk would bring them back as ordinary fish
+        if (std::max(std::abs(cx - fcx), std::abs(cy - fcy)) <= m_residentRadius + 1
+            || std::static_pointer_cast<NPCreature>(creature)->isBoss()) {
+            m_creatures[kept++] = creature;
+            continue;
+        }
+        m_effects.Clear(*creature); // the record on disk has no room for them
+        this->batchOf(*creature).remove(creature.get());
+        RegionCreatureRecord record;
+        record.type = uint8_t(std::static_pointer_cast<NPCreature>(creature)->GetType());
+        record.speed = uint8_t(creature->getSpeed());
+        record.x = creature->getX();
+        record.y = creature->getY();
+        record.dx = creature->getDx();
+        record.dy = creature->getDy();
+        record.phase = creature->getKinematicState().phase;
+        record.pattern = uint8_t(creature->getMotionPattern());
+        if (record.type == uint8_t(AquariumCreatureType::PowerUp)) {
+            record.grant = uint8_t(std::static_pointer_cast<PowerUp>(creature)->getGrant().kind);
+        }
+        evicted[(static_cast<long long>(cx) << 32) ^ static_cast<uint32_t>(cy)].push_back(record);
+    }
+    m_creatures.resize(kept);
+    for (const auto& region : evicted) {
+        m_regionStore.Evict(int(region.first >> 32), int(int32_t(uint32_t(region.first))), region.second);
+    }
+
+    std::vector<RegionCreatureRecord> loaded;
+    for (int cy = fcy - m_residentRadius; cy <= fcy + m_residentRadius; ++cy) {
+        for (int cx = fcx - m_residentRadius; cx <= fcx + m_residentRadius; ++cx) {
+            m_regionStore.Load(cx, cy, loaded);
+        }
+    }
+    for (const RegionCreatureRecord& record : loaded) {
+        std::shared_ptr<NPCreature> creature = this->MakeCreature(
+            static_cast<AquariumCreatureType>(record.type), record.x, record.y, record.speed);
+        if (!creature) continue;
+        // constructors adjust the speed they are given (jellyfish halve it), the record already has the result
+        creature->setSpeed(record.speed);
+        KinematicState state = creature->getKinematicState();
+        state.dx = record.dx;
+        state.dy = record.dy;
+        state.phase = record.phase;
+        creature->setKinematicState(state);
+        creature->setMotionPattern(record.pattern);
+        if (creature->GetType() == AquariumCreatureType::PowerUp) {
+            // the one the player may have seen before it streamed out, not a new roll
+            std::static_pointer_cast<PowerUp>(creature)->setGrant(PowerUp::GrantFor(EffectKind(record.grant)));
+        }
+        this->addCreature(creature);
+    }
+    if (!evicted.empty() || !loaded.empty()) {
+        m_spatialIndexDirty = true;
+        ofLogVerbose() << "streamed out " << evicted.size() << " regions, streamed in " << loaded.size()
+                       << " creatures, " << m_regionStore.GetStoredCreatureCount() << " creatures on disk" << endl;
+    }
 }
 
 
@@ -322,6 +848,7 @@ void Aquarium::SpawnCreature(AquariumCreatureType type) {
 // which will mean incrementing the buffer and pointing to a new lvl index
 void Aquarium::Repopulate() {
     ofLogVerbose("entering phase repopulation");
+    if(this->m_aquariumlevels.empty()){return;} // nothing to pick a population from
     // lets make the levels circular
     int selectedLevelIdx = this->currentLevel % this->m_aquariumlevels.size();
     ofLogVerbose() << "the current index: " << selectedLevelIdx << endl;
@@ -329,6 +856,7 @@ void Aquarium::Repopulate() {
 
 
     if(level->isCompleted()){
+        m_scripts.Cancel(this->currentLevel); // waves and bosses end with their level
         level->levelReset();
         this->currentLevel += 1;
         selectedLevelIdx = this->currentLevel % this->m_aquariumlevels.size();
@@ -338,119 +866,316 @@ void Aquarium::Repopulate() {
     }
 
     
+    if(m_scriptedLevel != this->currentLevel){
+        m_scriptedLevel = this->currentLevel;
+        level->StartScripts(*this);
+    }
+
     // now lets find how many to respawn if needed 
     std::vector<AquariumCreatureType> toRespawn = level->Repopulate();
     ofLogVerbose() << "amount to repopulate : " << toRespawn.size() << endl;
     if(toRespawn.size() <= 0 ){return;} // there is nothing for me to do here
-    for(AquariumCreatureType newCreatureType : toRespawn){
-        this->SpawnCreature(newCreatureType);
-    }
+    this->SpawnCreatures(toRespawn);
+}
+
+
+void AddDefaultAquariumLevels(std::shared_ptr<Aquarium> aquarium) {
+    aquarium->addAquariumLevel(MakeTracked<MemorySubsystem::LEVELS, Level_0>(0, 10));
+    aquarium->addAquariumLevel(MakeTracked<MemorySubsystem::LEVELS, Level_1>(1, 15));
+    aquarium->addAquariumLevel(MakeTracked<MemorySubsystem::LEVELS, Level_2>(2, 20));
+    aquarium->addAquariumLevel(MakeTracked<MemorySubsystem::LEVELS, Level_3>(3, 28));
 }
 
 
 // Aquarium collision detection
-std::shared_ptr<GameEvent> DetectAquariumCollisions(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player) {
-    if (!aquarium || !player) return nullptr;
-    
-    //Checks NPC vs Player collisions
-    for (int i = 0; i < aquarium->getCreatureCount(); ++i) {
-        std::shared_ptr<Creature> npc = aquarium->getCreatureAt(i);
-        if (npc && checkCollision(player, npc)) {
-            return std::make_shared<GameEvent>(GameEventType::COLLISION, player, npc);
+void DetectAquariumCollisions(Aquarium& aquarium, const std::vector<std::shared_ptr<PlayerCreature>>& players,
+                              std::vector<std::shared_ptr<GameEvent>>& out, std::vector<int>& nearby) {
+    out.clear();
+    const SpatialGrid& grid = aquarium.getSpatialIndex();
+    const std::vector<std::shared_ptr<Creature>>& creatures = aquarium.getCreatures();
+    for (const std::shared_ptr<PlayerCreature>& player : players) {
+        if (player->getLives() <= 0) continue;
+        //Checks NPC vs Player collisions, only the creatures the player could have swept into
+        // anything it touched in the interval is within both paths' reach plus both radii of it now
+        float reach = player->getCollisionRadius() + player->getSweepReach() + grid.GetMaxSweep();
+        grid.QueryRadius(player->getX(), player->getY(), reach, nearby);
+        // a check covers several ticks, so everything met on the way counts, not just the first
+        for (int i : nearby) {
+            if (checkSweptCollision(player, creatures[i])) {
+                out.push_back(MakeTracked<MemorySubsystem::EVENTS, GameEvent>(GameEventType::COLLISION, player, creatures[i]));
+            }
         }
     }
+    // NPC vs NPC contacts are not events, Aquarium::ResolveContacts handles all of them at once
+}
 
-    //Checks NPC vs NPC collisions
-    int count = aquarium->getCreatureCount();
-    for (int i = 0; i < count; ++i){
-        std::shared_ptr<Creature> a = aquarium->getCreatureAt(i);
-        if(!a || std::static_pointer_cast<NPCreature>(a)->GetType() == AquariumCreatureType::PowerUp) continue;
-        for(int j = i + 1; j < count; ++j){
-            std::shared_ptr<Creature> b = aquarium->getCreatureAt(j);
-            if(!b || std::static_pointer_cast<NPCreature>(b)->GetType() == AquariumCreatureType::PowerUp) continue;
-            if(checkCollision(a, b)){
-                return std::make_shared<GameEvent>(GameEventType::COLLISION, a, b);
-            }
-        }
+
+PlayerKeys GetLocalPlayerKeys(int player) {
+    switch (player) {
+        case 0: return PlayerKeys{OF_KEY_UP, OF_KEY_DOWN, OF_KEY_LEFT, OF_KEY_RIGHT};
+        case 1: return PlayerKeys{'i', 'k', 'j', 'l'};
+        case 2: return PlayerKeys{'t', 'g', 'f', 'h'};
+        default: return PlayerKeys{};
     }
-    return nullptr;
-};
+}
+
+int GetLocalPlayerKeyLayouts() {
+    return 3;
+}
+
 
 //  Imlementation of the AquariumScene
 
-void AquariumGameScene::Update(){
-    std::shared_ptr<GameEvent> event;
+int AquariumGameScene::AddPlayer(std::shared_ptr<PlayerCreature> player, const PlayerKeys& keys){
+    this->m_players.push_back(std::move(player));
+    this->m_controls.push_back(PlayerControls{keys});
+    this->m_hud.invalidate();
+    this->keepSpawnsAwayFromPlayers();
+    return this->m_players.size() - 1;
+}
 
-    this->m_player->update();
+bool AquariumGameScene::IsPlayerKey(int key) const {
+    for(const PlayerControls& controls : this->m_controls){
+        if(controls.keys.owns(key)) return true;
+    }
+    return false;
+}
 
+void AquariumGameScene::Update(){
+    // input only ever takes effect here, once per tick, in the order it arrived
+    ++this->m_tick;
+    this->m_input.Drain(this->m_tick, [this](const InputEvent& e){ this->applyInput(e); });
+    for(const std::shared_ptr<PlayerCreature>& player : this->m_players){
+        if(player->getLives() <= 0) continue;
+        player->setModifiers(this->m_aquarium->getEffects().Get(*player));
+        player->update(this->m_aquarium->getBounds());
+        player->recordSweepStep();
+        if(player->getModifiers().magnetRadius > 0){
+            this->applyMagnet(*player, player->getModifiers().magnetRadius);
+        }
+    }
+    this->keepSpawnsAwayFromPlayers();
+    this->keepCameraOnPlayers();
+    uint64_t sectionStart = FrameClockMicros();
+    // the players share the screen, so the tank is streamed around the middle of them
+    this->m_aquarium->StreamRegions(this->m_focusX, this->m_focusY);
+    this->m_timings.streamingUs = FrameClockMicros() - sectionStart;
+    // full rate simulation for what is on screen plus a screen's worth of slack around it
+    this->m_aquarium->setActiveArea(
+        this->m_camera.getX() - this->m_camera.getViewWidth() / 2,
+        this->m_camera.getY() - this->m_camera.getViewHeight() / 2,
+        this->m_camera.getViewWidth() * 2, this->m_camera.getViewHeight() * 2);
+
+    this->m_timings.collisionsUs = 0;
+    // the sweeps follow every tick since the last check, so checking every few ticks misses nothing
     if (this->updateControl.tick()) {
-        event = DetectAquariumCollisions(this->m_aquarium, this->m_player);
-        if (event != nullptr && event->isCollisionEvent()) {
-            if(event->creatureA == this->m_player){
-               ofLogVerbose() << "Collision detected between player and NPC!" << std::endl;
-                if(event->creatureB != nullptr){
-                    event->print();
-                    //Player vs PowerUp collisions
-                    if(std::static_pointer_cast<NPCreature>(event->creatureB)->GetType() == AquariumCreatureType::PowerUp){
-                        this->m_player->applySpeedBoost(2, 300);
-                        this->m_aquarium->removeCreature(event->creatureB);
-                    }
-                    //Player vs NPC collisions
-                    else if(this->m_player->getPower() < event->creatureB->getValue()){
-                        ofLogNotice() << "Player is too weak to eat the creature!" << std::endl;
-                        this->m_player->loseLife(3*60); // 3 frames debounce, 3 seconds at 60fps
-                        if(this->m_player->getLives() <= 0){
-                            this->m_lastEvent = std::make_shared<GameEvent>(GameEventType::GAME_OVER, this->m_player, nullptr);
-                            return;
-                        }
-                    }
-                    else{
-                        if(eatSound) eatSound->play();
-                        this->m_aquarium->removeCreature(event->creatureB);
-                        this->m_player->addToScore(1, event->creatureB->getValue());
-                        if (this->m_player->getScore() % 25 == 0){
-                            this->m_player->increasePower(1);
-                            ofLogNotice() << "Player power increased to " << this->m_player->getPower() << "!" << std::endl;
-                        }
-                    }
-                } else {
-                    ofLogError() << "Error: creatureB is null in collision event." << std::endl;
-                } 
-            }else{//NPC vs NPC collisions
-                if(event->creatureA && event->creatureB){
-                    if(collisionSound) collisionSound->play();
-                    event->creatureA->bounce(event->creatureB);
-                }
-            }  
-        } 
-            
+        sectionStart = FrameClockMicros();
+        DetectAquariumCollisions(*this->m_aquarium, this->m_players, this->m_hits, this->m_nearbyScratch);
+        std::shared_ptr<PlayerCreature> lastOut;
+        for(const std::shared_ptr<GameEvent>& event : this->m_hits){
+            auto player = std::static_pointer_cast<PlayerCreature>(event->creatureA);
+            if(player->getLives() <= 0) continue; // out on an earlier hit of the same check
+            ofLogVerbose() << "Collision detected between player and NPC!" << std::endl;
+            event->print();
+            if(!this->resolvePlayerHit(*player, event->creatureB)){
+                lastOut = player;
+            }
+        }
+        this->m_hits.clear();
+        if(lastOut != nullptr){
+            bool anyoneLeft = std::any_of(this->m_players.begin(), this->m_players.end(),
+                [](const std::shared_ptr<PlayerCreature>& p){ return p->getLives() > 0; });
+            if(!anyoneLeft){
+                this->m_lastEvent = MakeTracked<MemorySubsystem::EVENTS, GameEvent>(GameEventType::GAME_OVER, lastOut, nullptr);
+                return;
+            }
+            ofLogNotice() << "a player is out, " << this->m_players.size() << " started" << std::endl;
+        }
+        //NPC vs NPC collisions, a few passes are enough for a crowded level to settle
+        // contacts happen most checks in a crowded level, restarting the sound each time would only buzz
+        if (this->m_aquarium->ResolveContacts(4) > 0) {
+            if(collisionSound && !collisionSound->isPlaying()) collisionSound->play();
+        }
+        // next sweep starts from where everyone ended up after resolving this one
+        for(const std::shared_ptr<PlayerCreature>& player : this->m_players){
+            player->markCollisionCheckpoint();
+        }
+        this->m_aquarium->markCollisionCheckpoint();
+        this->m_timings.collisionsUs = FrameClockMicros() - sectionStart;
     }
+    sectionStart = FrameClockMicros();
     this->m_aquarium->update();
+    this->m_timings.simulationUs = FrameClockMicros() - sectionStart;
+}
+
+bool AquariumGameScene::resolvePlayerHit(PlayerCreature& player, const std::shared_ptr<Creature>& npc){
+    // two players can reach the same creature in one sweep, whoever came first got it
+    const auto& creatures = this->m_aquarium->getCreatures();
+    if(std::find(creatures.begin(), creatures.end(), npc) == creatures.end()){
+        return true;
+    }
+    //Player vs PowerUp collisions
+    if(std::static_pointer_cast<NPCreature>(npc)->GetType() == AquariumCreatureType::PowerUp){
+        const EffectGrant& grant = std::static_pointer_cast<PowerUp>(npc)->getGrant();
+        this->m_aquarium->getEffects().Apply(player, grant);
+        ofLogNotice() << "Player picked up " << EffectKindToString(grant.kind) << " for " << grant.ticks << " ticks" << std::endl;
+        this->m_aquarium->removeCreature(npc);
+    }
+    //Player vs NPC collisions
+    else if(player.getPower() < npc->getValue()){
+        ofLogNotice() << "Player is too weak to eat the creature!" << std::endl;
+        player.loseLife(3*60); // 3 frames debounce, 3 seconds at 60fps
+        if(player.getLives() <= 0){
+            this->m_aquarium->getEffects().Clear(player);
+            return false;
+        }
+    }
+    else{
+        if(eatSound) eatSound->play();
+        this->m_aquarium->removeCreature(npc);
+        player.addToScore(1, npc->getValue());
+        if (player.getScore() % 25 == 0){
+            player.increasePower(1);
+            ofLogNotice() << "Player power increased to " << player.getPower() << "!" << std::endl;
+        }
+    }
+    return true;
 }
 
 
 
+// far enough that nothing spawns where a player could run into it before seeing it
+void AquariumGameScene::keepSpawnsAwayFromPlayers(){
+    this->m_aquarium->clearSpawnSafeZones();
+    for(const std::shared_ptr<PlayerCreature>& player : this->m_players){
+        if(player->getLives() <= 0) continue;
+        this->m_aquarium->addSpawnSafeZone(player->getX(), player->getY(), player->getCollisionRadius() + 200.0f);
+    }
+}
+
+// the camera looks at the middle of the players still in the game, or where they were last
+void AquariumGameScene::keepCameraOnPlayers(){
+    float x = 0, y = 0;
+    int in = 0;
+    for(const std::shared_ptr<PlayerCreature>& player : this->m_players){
+        if(player->getLives() <= 0) continue;
+        x += player->getX();
+        y += player->getY();
+        ++in;
+    }
+    if(in > 0){
+        this->m_focusX = x / in;
+        this->m_focusY = y / in;
+    }
+    this->m_camera.setWorld(this->m_aquarium->getWidth(), this->m_aquarium->getHeight());
+    this->m_camera.follow(this->m_focusX, this->m_focusY);
+}
+
+// edible creatures in reach turn a little towards the player every tick, the rest are left alone
+void AquariumGameScene::applyMagnet(const PlayerCreature& player, float radius){
+    this->m_aquarium->QueryRadius(player.getX(), player.getY(), radius, this->m_magnetScratch);
+    for(const std::shared_ptr<Creature>& c : this->m_magnetScratch){
+        if(c->getValue() > player.getPower()) continue;
+        float dx = player.getX() - c->getX();
+        float dy = player.getY() - c->getY();
+        float dist = std::sqrt(dx * dx + dy * dy);
+        if(dist <= 0) continue;
+        c->setVelocity(c->getDx() + 0.25f * dx / dist, c->getDy() + 0.25f * dy / dist);
+        c->normalize();
+    }
+    this->m_magnetScratch.clear();
+}
+
+void AquariumGameScene::applyInput(const InputEvent& e){
+    // remote inputs name their player and use the arrow keys, local ones are found by their key
+    int index = e.player;
+    PlayerKeys keys = GetLocalPlayerKeys(0);
+    if(index < 0){
+        for(size_t i = 0; i < this->m_controls.size() && index < 0; ++i){
+            if(this->m_controls[i].keys.owns(e.key)) index = i;
+        }
+        if(index < 0) return;
+        keys = this->m_controls[index].keys;
+    }
+    if(size_t(index) >= this->m_players.size()) return;
+    PlayerControls& held = this->m_controls[index];
+    bool pressed = e.action == InputAction::PRESS;
+    if(e.key == keys.up) held.up = pressed;
+    else if(e.key == keys.down) held.down = pressed;
+    else if(e.key == keys.left) held.left = pressed;
+    else if(e.key == keys.right) held.right = pressed;
+    else return;
+    PlayerCreature& player = *this->m_players[index];
+    player.setDirection(int(held.right) - int(held.left), int(held.down) - int(held.up));
+    if(pressed && e.key == keys.left){
+        player.setFlipped(true);
+    } else if(pressed && e.key == keys.right){
+        player.setFlipped(false);
+    }
+}
+
 void AquariumGameScene::Draw() {
-    this->m_player->draw();
-    this->m_aquarium->draw();
+    this->m_camera.begin();
+    for(const std::shared_ptr<PlayerCreature>& player : this->m_players){
+        if(player->getLives() > 0) player->draw();
+    }
+    this->m_aquarium->draw(this->m_camera);
+    this->m_camera.end();
     this->paintAquariumHUD();
 
 }
 
 
 void AquariumGameScene::paintAquariumHUD(){
-    float panelWidth = ofGetWindowWidth() - 150;
-    float panelHeight = ofGetWindowHeight() - 500;
-    ofDrawBitmapString("Score: " + std::to_string(this->m_player->getScore()), panelWidth, 20);
-    ofDrawBitmapString("Power: " + std::to_string(this->m_player->getPower()), panelWidth, 30);
-    ofDrawBitmapString("Lives: " + std::to_string(this->m_player->getLives()), panelWidth, 40);
-    if(this->m_player->isBoostActive()){
-        ofSetColor(ofColor::lightGreen);
-        ofDrawBitmapString("YOU HAVE 2X SPEED!", ofGetWindowWidth()/2 - 75, panelHeight);
+    this->m_hud.draw(this->m_players, ofGetWindowWidth(), ofGetWindowHeight());
+}
+
+
+void AquariumHUD::draw(const std::vector<std::shared_ptr<PlayerCreature>>& players, int windowWidth, int windowHeight){
+    if(m_shown.size() != players.size()){
+        m_shown.resize(players.size());
+        m_layer.invalidate();
     }
-    for (int i = 0; i < this->m_player->getLives(); ++i) {
-        ofSetColor(ofColor::red);
-        ofDrawCircle(panelWidth + i * 20, 50, 5);
+    for(size_t i = 0; i < players.size(); ++i){
+        Shown now{players[i]->getScore(), players[i]->getPower(), players[i]->getLives(), players[i]->getModifiers().active};
+        if(now != m_shown[i]){
+            m_shown[i] = now;
+            m_layer.invalidate();
+        }
+    }
+    m_layer.draw(windowWidth, windowHeight);
+}
+
+void AquariumHUD::repaint(int windowWidth){
+    // short enough for the small string buffer, so no heap traffic even on a repaint
+    char line[24];
+    for(size_t p = 0; p < m_shown.size(); ++p){
+        const Shown& shown = m_shown[p];
+        float panelWidth = windowWidth - 150 - 150 * float(p);
+        ofSetColor(ofColor::white);
+        if(m_shown.size() > 1){
+            std::snprintf(line, sizeof(line), "Player %d", int(p) + 1);
+            ofDrawBitmapString(line, panelWidth, 10);
+        }
+        std::snprintf(line, sizeof(line), "Score: %d", shown.score);
+        ofDrawBitmapString(line, panelWidth, 20);
+        std::snprintf(line, sizeof(line), "Power: %d", shown.power);
+        ofDrawBitmapString(line, panelWidth, 30);
+        std::snprintf(line, sizeof(line), "Lives: %d", shown.lives);
+        ofDrawBitmapString(line, panelWidth, 40);
+        for (int i = 0; i < shown.lives; ++i) {
+            ofSetColor(ofColor::red);
+            ofDrawCircle(panelWidth + i * 20, 50, 5);
+        }
+        // one line per running effect under the player's panel
+        float effectY = 70;
+        ofSetColor(ofColor::lightGreen);
+        for(int kind = 0; kind < int(EffectKind::COUNT); ++kind){
+            if(!(shown.effects & (1u << kind))) continue;
+            std::snprintf(line, sizeof(line), "%s!", EffectKindToString(EffectKind(kind)));
+            ofDrawBitmapString(line, panelWidth, effectY);
+            effectY += 12;
+        }
     }
     ofSetColor(ofColor::white); // Reset color to white for other drawings
 }
@@ -458,16 +1183,31 @@ void AquariumGameScene::paintAquariumHUD(){
 void AquariumLevel::populationReset(){
     for(auto node: this->m_levelPopulation){
         node->currentPopulation = 0; // need to reset the population to ensure they are made a new in the next level
+        node->population = node->basePopulation; // and whatever the scripts did goes with it
     }
 }
 
+void AquariumLevel::AddPopulation(AquariumCreatureType creatureType, int delta){
+    for(std::shared_ptr<AquariumLevelPopulationNode> node: this->m_levelPopulation){
+        if(node->creatureType == creatureType){
+            // fish already out keep swimming when it shrinks, they just are not replaced
+            node->population = std::max(0, node->population + delta);
+            return;
+        }
+    }
+    if(delta <= 0){return;}
+    auto node = MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(creatureType, 0);
+    node->population = delta;
+    this->m_levelPopulation.push_back(node);
+}
+
 void AquariumLevel::ConsumePopulation(AquariumCreatureType creatureType, int power){
     for(std::shared_ptr<AquariumLevelPopulationNode> node: this->m_levelPopulation){
         ofLogVerbose() << "consuming from this level creatures" << endl;
         if(node->creatureType == creatureType){
             ofLogVerbose() << "-cosuming from type: " << AquariumCreatureTypeToString(node->creatureType) <<" , currPop: " << node->currentPopulation << endl;
             if(node->currentPopulation == 0){
-                return;
+                continue; // a level can have more than one node of a type, the fish may be from a later one
             } 
             node->currentPopulation -= 1;
             ofLogVerbose() << "+cosuming from type: " << AquariumCreatureTypeToString(node->creatureType) <<" , currPop: " << node->currentPopulation << endl;
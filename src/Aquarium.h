@@ -1,10 +1,22 @@
+#pragma once
 #define NOMINMAX // To avoid min/max macro conflict on Windows
 
 #include <vector>
 #include <memory>
 #include <iostream>
 #include <algorithm>
+#include <array>
 #include "Core.h"
+#include "Broadphase.h"
+#include "AquariumRegions.h"
+#include "CreatureKinematics.h"
+#include "InputQueue.h"
+#include "SpawnPlacement.h"
+#include "ContactSolver.h"
+#include "FramePacing.h"
+#include "SpriteAtlas.h"
+#include "LevelScript.h"
+#include "TimedEffects.h"
 
 
 enum class AquariumCreatureType {
@@ -15,21 +27,60 @@ enum class AquariumCreatureType {
     PowerUp
 };
 
+const int kAquariumCreatureTypeCount = 5;
+
+// the game was tuned at two updates per 60 Hz frame, speeds, turn rates, animations and timers
+// all assume it, so everything that runs the tank in real time or turns ticks into seconds uses these
+const int kAquariumTicksPerFrame = 2;
+const int kAquariumTicksPerSecond = 60 * kAquariumTicksPerFrame;
+
 string AquariumCreatureTypeToString(AquariumCreatureType t);
 
+// boids style schooling, each weight scales one steering rule
+// neighbors only count when they are the same kind of creature
+struct SchoolingWeights {
+    bool enabled = false;
+    float separation = 0.0f; // push away from fish that are too close
+    float alignment = 0.0f;  // turn towards the average heading
+    float cohesion = 0.0f;   // drift towards the middle of the school
+    float neighborRadius = 0.0f;
+};
+
+// running totals since the aquarium was made, cheap enough to keep on all the time
+struct AquariumStats {
+    long spawned = 0;   // new creatures, streaming a region back in does not count
+    long removed = 0;   // eaten or otherwise taken out, clearing a level does not count
+    long contacts = 0;  // creature vs creature contacts the solver handled
+    long preyEaten = 0; // creatures eaten by other creatures in ecosystem mode, also in removed
+    long ticks = 0;     // update() calls, however many of them a caller runs per frame
+};
+
+// who eats whom in ecosystem mode, one entry per predator type
+struct PredatorDiet {
+    uint8_t preyMask = 0;    // bit per AquariumCreatureType it eats
+    float huntRadius = 0;    // how far away it notices prey, measured center to center
+    bool chases = false;     // steers towards its prey, otherwise it waits for prey to touch it
+    bool stings = false;     // venom kills prey of any rank, everyone else only eats lower values
+    float turnRate = 0;      // share of the heading turned towards the prey per tick
+};
+
 class AquariumLevelPopulationNode{
     public:
         AquariumLevelPopulationNode() = default;
         AquariumLevelPopulationNode(AquariumCreatureType creature_type, int population) {
             this->creatureType = creature_type;
             this->population = population;
+            this->basePopulation = population;
             this->currentPopulation = 0;
         };
         AquariumCreatureType creatureType;
         int population;
+        int basePopulation; // what the level starts with, scripts move population around it
         int currentPopulation;
 };
 
+class Aquarium;
+
 class AquariumLevel : public GameLevel {
     public:
         AquariumLevel(int levelNumber, int targetScore)
@@ -39,6 +90,13 @@ class AquariumLevel : public GameLevel {
         void populationReset();
         void levelReset(){m_level_score=0;this->populationReset();}
         virtual std::vector<AquariumCreatureType> Repopulate();
+        // for the level's scripts, a wave raises a population for a while and an escalation for good
+        void AddPopulation(AquariumCreatureType creature, int delta);
+        void AddScore(int score) { m_level_score += score; }
+        const std::vector<std::shared_ptr<AquariumLevelPopulationNode>>& GetPopulation() const { return m_levelPopulation; }
+        // called when the level starts, start its scripts through Aquarium::StartLevelScript
+        // they are cancelled when the level is left
+        virtual void StartScripts(Aquarium& /*aquarium*/) {}
     protected:
         std::vector<std::shared_ptr<AquariumLevelPopulationNode>> m_levelPopulation;
         int m_level_score;
@@ -51,91 +109,116 @@ class PlayerCreature : public Creature {
 public:
 
     PlayerCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    void move();
-    void draw() const;
-    void update();
+    void move(const WorldBounds& world) override;
+    void draw() const override;
+    void update(const WorldBounds& world);
     void changeSpeed(int speed);
     void setLives(int lives) { m_lives = lives; }
     void setDirection(float dx, float dy);
     float isXDirectionActive() { return m_dx != 0; }
     float isYDirectionActive() {return m_dy != 0; }
-    float getDx() { return m_dx; }
-    float getDy() { return m_dy; }
 
     int getScore()const { return m_score; }
     int getLives() const { return m_lives; }
     int getPower() const { return m_power; }
-    bool isBoostActive() const {return m_isBoosted;}
+    // what the timed effects on the player add up to, set by the scene every tick
+    const EffectModifiers& getModifiers() const { return m_modifiers; }
+    void setModifiers(const EffectModifiers& modifiers) { m_modifiers = modifiers; }
+    float getCollisionRadius() const override { return m_collisionRadius * m_modifiers.size; }
+    // tells players apart when more than one shares the tank
+    void setTint(const ofColor& tint) { m_tint = tint; }
     
-    void addToScore(int amount, int weight=1) { m_score += amount * weight; }
+    void addToScore(int amount, int weight=1) { m_score += int(std::lround(amount * weight * m_modifiers.score)); }
     void loseLife(int debounce);
     void increasePower(int value) { m_power += value; }
     void reduceDamageDebounce();
-
-    //powerup
-    void applySpeedBoost(int amount, int durationFrames){
-        if(!m_isBoosted){
-            m_speedBoostFrames = std::max(m_speedBoostFrames, durationFrames);
-            m_base_speed = this->m_speed;
-            m_speed *= amount;
-            m_isBoosted = true;
-        }
-        
-    }
     
 private:
     int m_score = 0;
     int m_lives = 3;
     int m_power = 1; // mark current power lvl
     int m_damage_debounce = 0; // frames to wait after eating
-    int m_base_speed = 0;
-    int m_speedBoostFrames = 0;
-    bool m_isBoosted = false;
+    EffectModifiers m_modifiers;
+    ofColor m_tint = ofColor::white;
+};
+
+// the keys that steer one player, a player without keys is only steered from the network
+struct PlayerKeys {
+    int up = 0;
+    int down = 0;
+    int left = 0;
+    int right = 0;
+    bool owns(int key) const { return key != 0 && (key == up || key == down || key == left || key == right); }
 };
 
+// the layouts for players sharing the keyboard: arrows, then ijkl, then tfgh
+// players past those get no keys
+PlayerKeys GetLocalPlayerKeys(int player);
+int GetLocalPlayerKeyLayouts();
+
 class NPCreature : public Creature {
 public:
     NPCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
     AquariumCreatureType GetType() const {return this->m_creatureType;}
-    void move() override;
+    void move(const WorldBounds& world) override;
     void draw() const override;
     void setCreatureType(AquariumCreatureType type) {m_creatureType = type;}
+    // bosses come from level scripts, they are bigger, worth more and outside the level's population
+    bool isBoss() const { return m_bossScale > 1; }
+    float getBossScale() const { return m_bossScale; }
+    void makeBoss(float scale);
 protected:
     AquariumCreatureType m_creatureType;
+    float m_bossScale = 1;
 
 };
 class JellyFish : public NPCreature{
 public: 
 JellyFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    void move() override;
+    void move(const WorldBounds& world) override;
     void draw() const override;
-private:
-    float t = 0.0f;
 };
 
 class FastFish : public NPCreature{
 public:
     FastFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    void move() override;
+    void move(const WorldBounds& world) override;
     void draw() const override;
-private:
-    int step = 0;
 };
 
 class BiggerFish : public NPCreature {
 public:
     BiggerFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    void move() override;
+    void move(const WorldBounds& world) override;
     void draw() const override;
 };
 
+// drifts around until the player picks it up, then hands the player a timed effect
+class PowerUp : public NPCreature {
+public:
+    PowerUp(float x, float y, std::shared_ptr<GameSprite> sprite, const EffectGrant& grant);
+    const EffectGrant& getGrant() const { return m_grant; }
+    void setGrant(const EffectGrant& grant) { m_grant = grant; }
+    // what a power up of the given kind hands out, there is one grant per kind
+    static EffectGrant GrantFor(EffectKind kind);
+    // one of them picked with CreatureRandom
+    static EffectGrant RandomGrant();
+private:
+    EffectGrant m_grant;
+};
+
 
 class AquariumSpriteManager {
     public:
         AquariumSpriteManager();
         ~AquariumSpriteManager() = default;
         std::shared_ptr<GameSprite>GetSprite(AquariumCreatureType t);
+        // sprites are square and scaled to this many pixels a side when loaded
+        static int GetSpriteSide(AquariumCreatureType t);
+        static const SpriteAnimation& GetAnimation(AquariumCreatureType t);
+        SpriteAtlas& GetAtlas() { return m_atlas; }
     private:
+        SpriteAtlas m_atlas;
         std::shared_ptr<GameSprite> m_npc_fish;
         std::shared_ptr<GameSprite> m_big_fish;
         std::shared_ptr<GameSprite> m_jelly_fish;
@@ -147,42 +230,194 @@ class AquariumSpriteManager {
 class Aquarium{
 public:
     Aquarium(int width, int height, std::shared_ptr<AquariumSpriteManager> spriteManager);
+    // NPCreatures only, anything else is refused so the rest can rely on it
     void addCreature(std::shared_ptr<Creature> creature);
     void addAquariumLevel(std::shared_ptr<AquariumLevel> level);
     void removeCreature(std::shared_ptr<Creature> creature);
     void clearCreatures();
     void update();
-    void draw() const;
+    void draw(const GameCamera& camera) const;
     void setBounds(int w, int h);
+    // creatures inside the area update every tick, the rest every m_farUpdateInterval ticks
+    void setActiveArea(float x, float y, float w, float h);
+    void setFarUpdateInterval(int ticks) { m_farUpdateInterval = std::max(1, ticks); }
+    int getLastDrawCount() const { return m_lastDrawCount; }
     void setMaxPopulation(int n) { m_maxPopulation = n; }
     void Repopulate();
     void SpawnCreature(AquariumCreatureType type);
+    // places the whole batch clear of the creatures in the tank, of each other and of the safe zones
+    void SpawnCreatures(const std::vector<AquariumCreatureType>& types);
+    void clearSpawnSafeZones() { m_spawnSafeZones.clear(); }
+    void addSpawnSafeZone(float x, float y, float radius) { m_spawnSafeZones.push_back(SpawnSafeZone{x, y, radius}); }
+    // spawns of the last batch that found no clear spot and were put down overlapping
+    int getLastSpawnFallbacks() const { return m_spawnPlacer.GetFallbackCount(); }
+    std::shared_ptr<NPCreature> MakeCreature(AquariumCreatureType type, float x, float y, int speed);
+    // one scripted creature outside the level's population, scale grows its size and its worth
+    // placed at its grown size, null when the tank has no clear spot that big right now
+    std::shared_ptr<NPCreature> SpawnBoss(AquariumCreatureType type, float scale);
+
+    // level scripts (see LevelScript.h) are resumed at the start of update()
+    // they belong to the level that is being played and are cancelled when it is left
+    void StartLevelScript(ScriptTask script) { m_scripts.Start(std::move(script), currentLevel); }
+    ScriptScheduler& getScripts() { return m_scripts; }
+    // timed effects on anything in the tank and on the player, they run out at the start of update()
+    EffectSystem& getEffects() { return m_effects; }
+    ofRectangle getSpawnArea() const;
+
+    // splits the tank into regionSize squares, the ones far from the focus live on disk
+    void enableRegionStreaming(const std::string& directory, float regionSize, int residentRadius);
+    void StreamRegions(float focusX, float focusY);
+    const AquariumRegionStore& getRegionStore() const { return m_regionStore; }
+    void markCollisionCheckpoint();
     
     std::shared_ptr<Creature> getCreatureAt(int index);
+    const std::vector<std::shared_ptr<Creature>>& getCreatures() const { return m_creatures; }
+    size_t getBatchedCount() const;
     int getCreatureCount() const { return m_creatures.size(); }
-    int getWidth() const { return m_width; }
-    int getHeight() const { return m_height; }
-
+    void CountByType(std::array<int, kAquariumCreatureTypeCount>& counts) const;
+    const AquariumStats& getStats() const { return m_stats; }
+    int getCurrentLevel() const { return currentLevel; }
+    // the level being played, null when no levels were added
+    std::shared_ptr<AquariumLevel> getActiveLevel() const;
+    int getWidth() const { return int(m_bounds.width); }
+    int getHeight() const { return int(m_bounds.height); }
+    const WorldBounds& getBounds() const { return m_bounds; }
+
+    void setSchoolingEnabled(bool enabled) { m_schoolingEnabled = enabled; }
+    bool isSchoolingEnabled() const { return m_schoolingEnabled; }
+    void setSchoolingWeights(AquariumCreatureType type, const SchoolingWeights& weights);
+    const SchoolingWeights& getSchoolingWeights(AquariumCreatureType type) const;
+
+    // finds every creature vs creature contact since the last checkpoint and solves them together
+    // returns how many contacts there were
+    int ResolveContacts(int iterations);
+    const ContactSolver& getContactSolver() const { return m_contactSolver; }
+
+    // creatures eat each other by the diets below, getValue() is the rank in the food chain
+    void setEcosystemEnabled(bool enabled) { m_ecosystemEnabled = enabled; }
+    bool isEcosystemEnabled() const { return m_ecosystemEnabled; }
+    void setPredatorDiet(AquariumCreatureType predator, const PredatorDiet& diet);
+    const PredatorDiet& getPredatorDiet(AquariumCreatureType predator) const;
+    int getLastEcosystemKills() const { return m_lastEcosystemKills; }
+    // how long the last tick's hunting took, zero while the ecosystem is off
+    uint32_t getLastEcosystemUs() const { return m_lastEcosystemUs; }
+
+    void setBroadphase(BroadphaseKind kind);
+    Broadphase& getBroadphase() { return *m_broadphase; }
+
+    // creatures whose collision circle touches the circle at (x, y), cost grows with what is nearby
+    void QueryRadius(float x, float y, float radius, std::vector<std::shared_ptr<Creature>>& out);
+    // rebuilt on demand after creatures were added, removed or moved
+    const SpatialGrid& getSpatialIndex();
 
 private:
+    void applySchooling();
+    void applyEcosystem();
+    void animate();
+    // a spawn batch: begin once, then place and add each creature, false when it found no clear spot
+    void beginSpawns(const ofRectangle& area);
+    bool placeSpawn(const std::shared_ptr<NPCreature>& creature, bool requireClear);
+
     int m_maxPopulation = 0;
-    int m_width;
-    int m_height;
+    WorldBounds m_bounds;
     int currentLevel = 0;
     std::vector<std::shared_ptr<Creature>> m_creatures;
     std::vector<std::shared_ptr<Creature>> m_next_creatures;
     std::vector<std::shared_ptr<AquariumLevel>> m_aquariumlevels;
     std::shared_ptr<AquariumSpriteManager> m_sprite_manager;
+    std::unique_ptr<Broadphase> m_broadphase;
+    SpatialGrid m_spatialIndex;
+    bool m_spatialIndexDirty = true;
+    std::vector<int> m_queryScratch;
+    ContactSolver m_contactSolver;
+    AquariumStats m_stats;
+    ScriptScheduler m_scripts;
+    EffectSystem m_effects;
+    int m_scriptedLevel = -1; // the level whose scripts were started
+
+    SpawnPlacer m_spawnPlacer;
+    std::vector<SpawnSafeZone> m_spawnSafeZones;
+    float m_spawnGap = 8.0f; // extra room between a new creature and its neighbors
+
+    bool m_hasActiveArea = false;
+    ofRectangle m_activeArea;
+    int m_farUpdateInterval = 4;
+    int m_tick = 0;
+    mutable int m_lastDrawCount = 0;
+
+    AquariumRegionStore m_regionStore;
+    int m_residentRadius = 1;
+    int m_focusRegionX = 0;
+    int m_focusRegionY = 0;
+    int m_streamCountdown = 0;
+
+    bool m_schoolingEnabled = false;
+    std::array<SchoolingWeights, kAquariumCreatureTypeCount> m_schoolingWeights;
+    // per tick snapshot so the steering pass reads neighbors without chasing pointers
+    std::vector<float> m_schoolDx;
+    std::vector<float> m_schoolDy;
+    std::vector<int> m_schoolType;
+    std::vector<float> m_schoolSteerX;
+    std::vector<float> m_schoolSteerY;
+
+    bool m_ecosystemEnabled = false;
+    std::array<PredatorDiet, kAquariumCreatureTypeCount> m_diets;
+    int m_lastEcosystemKills = 0;
+    uint32_t m_lastEcosystemUs = 0;
+    // per tick snapshot, the target filter runs for every creature a hunt looks at
+    std::vector<uint8_t> m_ecoType;
+    std::vector<int> m_ecoValue;
+    std::vector<char> m_ecoEaten;
+    std::vector<char> m_ecoClaimed;
+
+    // the tank's creatures by KinematicsKind, kept in step with m_creatures
+    std::array<KinematicBatch, kKinematicsKindCount> m_batches;
+    KinematicBatch& batchOf(const Creature& creature) { return m_batches[int(creature.getKinematicsKind())]; }
 };
 
 
-std::shared_ptr<GameEvent> DetectAquariumCollisions(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player);
+// the level progression the game ships with, shared by the app and the headless tools
+void AddDefaultAquariumLevels(std::shared_ptr<Aquarium> aquarium);
+
+// every player against the tank in one go, the spatial index is built once and each player
+// only looks at the cells it swept through, so the cost follows the creature count, not players x creatures
+// out gets a COLLISION event for every creature a player touched since the checkpoints
+// players without lives left are skipped
+// nearby is scratch for the grid queries, kept by the caller so a tick does not allocate
+void DetectAquariumCollisions(Aquarium& aquarium, const std::vector<std::shared_ptr<PlayerCreature>>& players,
+                              std::vector<std::shared_ptr<GameEvent>>& out, std::vector<int>& nearby);
+
+
+// score, power and lives painted once into an offscreen layer and blitted every frame
+// the layer is only repainted when one of the shown values or the window size changes,
+// so a frame where nothing happened costs a single textured quad and no string building
+// every player gets a panel of their own, right to left in player order
+class AquariumHUD {
+    public:
+        AquariumHUD() : m_layer([this](int w, int /*h*/){ this->repaint(w); }) {}
+        void draw(const std::vector<std::shared_ptr<PlayerCreature>>& players, int windowWidth, int windowHeight);
+        void invalidate() { m_layer.invalidate(); }
+    private:
+        struct Shown {
+            int score = 0;
+            int power = 0;
+            int lives = 0;
+            uint8_t effects = 0; // bit per EffectKind running on the player
+            bool operator!=(const Shown& o) const { return score != o.score || power != o.power || lives != o.lives || effects != o.effects; }
+        };
+        // panels hang from the top right corner, so only the width places them
+        void repaint(int windowWidth);
+
+        CachedLayer m_layer;
+        std::vector<Shown> m_shown;
+};
 
 
 class AquariumGameScene : public GameScene {
     public:
+        // the first player steers with the arrow keys, more can join with AddPlayer()
         AquariumGameScene(std::shared_ptr<PlayerCreature> player, std::shared_ptr<Aquarium> aquarium, string name)
-        : m_player(std::move(player)) , m_aquarium(std::move(aquarium)), m_name(name){}
+        : m_aquarium(std::move(aquarium)), m_name(name){ this->AddPlayer(std::move(player), GetLocalPlayerKeys(0)); }
         std::shared_ptr<GameEvent> GetLastEvent(){return m_lastEvent;}
         void SetLastEvent(std::shared_ptr<GameEvent> event){this->m_lastEvent = event;}
 
@@ -190,18 +425,55 @@ class AquariumGameScene : public GameScene {
         void SetCollisionSound(ofSoundPlayer* sound) {this->collisionSound = sound;}
         void SetEatSound(ofSoundPlayer* sound) {this->eatSound = sound;}
 
-        std::shared_ptr<PlayerCreature> GetPlayer(){return this->m_player;}
+        // returns the new player's index, the one remote inputs name it by
+        int AddPlayer(std::shared_ptr<PlayerCreature> player, const PlayerKeys& keys);
+        std::shared_ptr<PlayerCreature> GetPlayer(int index = 0){return this->m_players.at(index);}
+        const std::vector<std::shared_ptr<PlayerCreature>>& GetPlayers() const {return this->m_players;}
+        int GetPlayerCount() const {return this->m_players.size();}
+        // whether the key steers one of the players, those go through GetInput()
+        bool IsPlayerKey(int key) const;
         std::shared_ptr<Aquarium> GetAquarium(){return this->m_aquarium;}
+        GameCamera& GetCamera(){return this->m_camera;}
+        InputQueue& GetInput(){return this->m_input;}
+        // where the latest Update() went, for the frame pacing recorder
+        const UpdateBreakdown& GetLastUpdateTimings() const {return this->m_timings;}
         string GetName()override {return this->m_name;}
         void Update() override;
         void Draw() override;
     private:
         void paintAquariumHUD();
-        std::shared_ptr<PlayerCreature> m_player;
+        void applyInput(const InputEvent& e);
+        void keepSpawnsAwayFromPlayers();
+        void applyMagnet(const PlayerCreature& player, float radius);
+        // a player ran into npc, returns false once the player has no lives left
+        bool resolvePlayerHit(PlayerCreature& player, const std::shared_ptr<Creature>& npc);
+        void keepCameraOnPlayers();
+
+        // arrow keys, or that player's own keys, held down right now, the player heads the way they add up to
+        struct PlayerControls {
+            PlayerKeys keys;
+            bool up = false;
+            bool down = false;
+            bool left = false;
+            bool right = false;
+        };
+        std::vector<std::shared_ptr<PlayerCreature>> m_players;
+        std::vector<PlayerControls> m_controls;
+        std::vector<std::shared_ptr<GameEvent>> m_hits;
+        float m_focusX = 0;
+        float m_focusY = 0;
         std::shared_ptr<Aquarium> m_aquarium;
         std::shared_ptr<GameEvent> m_lastEvent;
+        GameCamera m_camera;
+        AquariumHUD m_hud;
+        InputQueue m_input;
+        UpdateBreakdown m_timings;
+        std::vector<std::shared_ptr<Creature>> m_magnetScratch;
+        std::vector<int> m_nearbyScratch;
+        uint32_t m_tick = 0;
         string m_name;
-        AwaitFrames updateControl{5};
+        // fires every kSweepPathSteps ticks, as many as a sweep path follows one at a time
+        AwaitFrames updateControl{kSweepPathSteps - 1};
         
         //Sound effects
         ofSoundPlayer* collisionSound = nullptr;
@@ -212,7 +484,7 @@ class AquariumGameScene : public GameScene {
 class Level_0 : public AquariumLevel  {
     public:
         Level_0(int levelNumber, int targetScore): AquariumLevel(levelNumber, targetScore){
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 10));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 10));
 
         };
 
@@ -221,35 +493,43 @@ class Level_1 : public AquariumLevel  {
     public:
         Level_1(int levelNumber, int targetScore): AquariumLevel(levelNumber, targetScore){
             
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 14));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 6));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 14));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 6));
 
         };
-
+        void StartScripts(Aquarium& aquarium) override;
+    private:
+        ScriptTask schoolWaves(Aquarium& aquarium);
 
 };
 class Level_2 : public AquariumLevel  {
     public:
         Level_2(int levelNumber, int targetScore): AquariumLevel(levelNumber, targetScore){
            
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 7));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::BiggerFish, 3));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::FastFish, 1));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::PowerUp, 2));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 7));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::BiggerFish, 3));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::FastFish, 1));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::PowerUp, 2));
 
         };
-
+        void StartScripts(Aquarium& aquarium) override;
+    private:
+        ScriptTask bossFights(Aquarium& aquarium);
 };
 
 class Level_3 : public AquariumLevel{
     public:
         Level_3(int levelNumber, int targetScore): AquariumLevel(levelNumber, targetScore){
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 6));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::BiggerFish, 2));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::FastFish, 3));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::JellyFish, 4));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::PowerUp, 2));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 6));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::BiggerFish, 2));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::FastFish, 3));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::JellyFish, 4));
+            this->m_levelPopulation.push_back(MakeTracked<MemorySubsystem::LEVELS, AquariumLevelPopulationNode>(AquariumCreatureType::PowerUp, 2));
 
         };
+        void StartScripts(Aquarium& aquarium) override;
+    private:
+        ScriptTask escalate(Aquarium& aquarium);
+        ScriptTask feedingFrenzy(Aquarium& aquarium);
 };
 
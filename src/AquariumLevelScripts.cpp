@@ -0,0 +1,81 @@
+#include "Aquarium.h"
+
+// the scripted side of the default levels, everything here runs as coroutines on the
+// aquarium's ScriptScheduler, one resume per wait, and ends when the level is left
+
+namespace {
+const uint32_t kTicksPerSecond = kAquariumTicksPerSecond;
+}
+
+
+// level 1: every 20 seconds a school of 8 joins for 10 seconds, the ones not eaten by then stay
+void Level_1::StartScripts(Aquarium& aquarium){
+    aquarium.StartLevelScript(this->schoolWaves(aquarium));
+}
+
+ScriptTask Level_1::schoolWaves(Aquarium& aquarium){
+    ScriptScheduler& scripts = aquarium.getScripts();
+    for(;;){
+        co_await scripts.Ticks(20 * kTicksPerSecond);
+        this->AddPopulation(AquariumCreatureType::NPCreature, 8);
+        co_await scripts.Ticks(10 * kTicksPerSecond);
+        this->AddPopulation(AquariumCreatureType::NPCreature, -8);
+    }
+}
+
+
+// level 2: a boss after 15 seconds, each one beaten brings a bigger one 20 seconds later
+void Level_2::StartScripts(Aquarium& aquarium){
+    aquarium.StartLevelScript(this->bossFights(aquarium));
+}
+
+ScriptTask Level_2::bossFights(Aquarium& aquarium){
+    ScriptScheduler& scripts = aquarium.getScripts();
+    co_await scripts.Ticks(15 * kTicksPerSecond);
+    for(float scale = 1.6f; ; scale += 0.3f){
+        // a crowded tank may have no room for it, waiting on a boss that never came would end the fights
+        while(!aquarium.SpawnBoss(AquariumCreatureType::BiggerFish, scale)){
+            co_await scripts.Ticks(kTicksPerSecond);
+        }
+        co_await scripts.Signal(ScriptSignal::BOSS_DEFEATED);
+        co_await scripts.Ticks(20 * kTicksPerSecond);
+    }
+}
+
+
+// level 3: the longer it goes the more crowded it gets, and eating fast stirs up the fast fish
+void Level_3::StartScripts(Aquarium& aquarium){
+    aquarium.StartLevelScript(this->escalate(aquarium));
+    aquarium.StartLevelScript(this->feedingFrenzy(aquarium));
+}
+
+ScriptTask Level_3::escalate(Aquarium& aquarium){
+    ScriptScheduler& scripts = aquarium.getScripts();
+    for(int step = 0; step < 4; ++step){
+        co_await scripts.Ticks(30 * kTicksPerSecond);
+        this->AddPopulation(AquariumCreatureType::JellyFish, 1);
+        this->AddPopulation(AquariumCreatureType::FastFish, 1);
+        ofLogNotice() << "the tank is getting crowded" << std::endl;
+    }
+}
+
+ScriptTask Level_3::feedingFrenzy(Aquarium& aquarium){
+    ScriptScheduler& scripts = aquarium.getScripts();
+    // ten meals within five seconds of the first one
+    int eaten = 0;
+    uint32_t windowEnd = 0;
+    for(;;){
+        // a predator feast or a collision batch can be several meals in one wakeup
+        uint32_t meals = co_await scripts.Signal(ScriptSignal::CREATURE_EATEN);
+        if(scripts.GetTick() >= windowEnd){
+            windowEnd = scripts.GetTick() + 5 * kTicksPerSecond;
+            eaten = 0;
+        }
+        eaten += meals;
+        if(eaten < 10) continue;
+        this->AddPopulation(AquariumCreatureType::FastFish, 5);
+        co_await scripts.Ticks(8 * kTicksPerSecond);
+        this->AddPopulation(AquariumCreatureType::FastFish, -5);
+        windowEnd = 0;
+    }
+}
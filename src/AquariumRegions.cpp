@@ -0,0 +1,130 @@
+#include "AquariumRegions.h"
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include "ofMain.h"
+
+
+namespace {
+
+void PackRecord(const RegionCreatureRecord& r, char* out){
+    int16_t qdx = int16_t(std::round(std::max(-1.0f, std::min(1.0f, r.dx)) * 32767));
+    int16_t qdy = int16_t(std::round(std::max(-1.0f, std::min(1.0f, r.dy)) * 32767));
+    out[0] = char(r.type);
+    out[1] = char(r.speed);
+    std::memcpy(out + 2, &r.x, 4);
+    std::memcpy(out + 6, &r.y, 4);
+    std::memcpy(out + 10, &qdx, 2);
+    std::memcpy(out + 12, &qdy, 2);
+    std::memcpy(out + 14, &r.phase, 4);
+    out[18] = char(r.grant);
+    out[19] = char(r.pattern);
+}
+
+RegionCreatureRecord UnpackRecord(const char* in){
+    RegionCreatureRecord r;
+    int16_t qdx, qdy;
+    r.type = uint8_t(in[0]);
+    r.speed = uint8_t(in[1]);
+    std::memcpy(&r.x, in + 2, 4);
+    std::memcpy(&r.y, in + 6, 4);
+    std::memcpy(&qdx, in + 10, 2);
+    std::memcpy(&qdy, in + 12, 2);
+    std::memcpy(&r.phase, in + 14, 4);
+    r.grant = uint8_t(in[18]);
+    r.pattern = uint8_t(in[19]);
+    r.dx = qdx / 32767.0f;
+    r.dy = qdy / 32767.0f;
+    return r;
+}
+
+}
+
+
+long long AquariumRegionStore::keyFor(int cx, int cy){
+    return (static_cast<long long>(cx) << 32) ^ static_cast<uint32_t>(cy);
+}
+
+std::string AquariumRegionStore::pathFor(int cx, int cy) const {
+    return m_directory + "/region_" + std::to_string(cx) + "_" + std::to_string(cy) + ".bin";
+}
+
+void AquariumRegionStore::Open(const std::string& directory, float regionSize){
+    m_directory = directory;
+    m_regionSize = regionSize;
+    std::error_code err;
+    std::filesystem::create_directories(m_directory, err);
+    if(err){
+        ofLogError() << "could not create region directory " << m_directory << ": " << err.message() << std::endl;
+    }
+    // regions from an old session would stream creatures into this one
+    for(const auto& entry : std::filesystem::directory_iterator(m_directory, err)){
+        if(entry.path().extension() == ".bin"){
+            std::filesystem::remove(entry.path(), err);
+        }
+    }
+    m_stored.clear();
+}
+
+void AquariumRegionStore::RegionOf(float x, float y, int& cx, int& cy) const {
+    cx = int(std::floor(x / m_regionSize));
+    cy = int(std::floor(y / m_regionSize));
+}
+
+void AquariumRegionStore::Evict(int cx, int cy, const std::vector<RegionCreatureRecord>& records){
+    if(records.empty()){return;}
+    std::vector<char> bytes(records.size() * kRecordSize);
+    for(size_t i = 0; i < records.size(); ++i){
+        PackRecord(records[i], bytes.data() + i * kRecordSize);
+    }
+    std::ofstream file(pathFor(cx, cy), std::ios::binary | std::ios::app);
+    if(!file.write(bytes.data(), bytes.size())){
+        ofLogError() << "failed to write region " << cx << "," << cy << std::endl;
+        return;
+    }
+    m_stored[keyFor(cx, cy)] += records.size();
+}
+
+bool AquariumRegionStore::HasStored(int cx, int cy) const {
+    return m_stored.count(keyFor(cx, cy)) > 0;
+}
+
+bool AquariumRegionStore::Load(int cx, int cy, std::vector<RegionCreatureRecord>& out){
+    auto found = m_stored.find(keyFor(cx, cy));
+    if(found == m_stored.end()){return false;}
+    std::string path = pathFor(cx, cy);
+    std::vector<char> bytes(size_t(found->second) * kRecordSize);
+    std::ifstream file(path, std::ios::binary);
+    if(!file.read(bytes.data(), bytes.size())){
+        ofLogError() << "region " << cx << "," << cy << " is shorter than expected, dropping it" << std::endl;
+        bytes.resize(file.gcount() - file.gcount() % kRecordSize);
+    }
+    file.close();
+    for(size_t at = 0; at < bytes.size(); at += kRecordSize){
+        out.push_back(UnpackRecord(bytes.data() + at));
+    }
+    m_stored.erase(found);
+    std::error_code err;
+    std::filesystem::remove(path, err);
+    return true;
+}
+
+void AquariumRegionStore::Clear(){
+    std::error_code err;
+    for(const auto& stored : m_stored){
+        int cx = int(stored.first >> 32);
+        int cy = int(int32_t(uint32_t(stored.first)));
+        std::filesystem::remove(pathFor(cx, cy), err);
+    }
+    m_stored.clear();
+}
+
+long AquariumRegionStore::GetStoredCreatureCount() const {
+    long total = 0;
+    for(const auto& stored : m_stored){
+        total += stored.second;
+    }
+    return total;
+}
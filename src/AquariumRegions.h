@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+
+// what a creature needs to come back to life after its region was streamed out
+// type and speed fit in a byte, the heading is a unit vector so 16 bits per axis are plenty
+// speed is the creature's own, after whatever its constructor did to the one it was given
+struct RegionCreatureRecord {
+    uint8_t type = 0;
+    uint8_t speed = 0;
+    float x = 0;
+    float y = 0;
+    float dx = 0;
+    float dy = 0;
+    float phase = 0; // where it is in its motion pattern
+    uint8_t grant = 0; // EffectKind a PowerUp hands out
+    uint8_t pattern = 0; // MotionTables id, a data file can give a creature another one than its type's
+};
+
+// on disk store for the regions of the tank that are too far from the player to keep in memory
+// every region is a fixed size square and gets its own file of packed records, evicting a region
+// that already has a file appends to it and loading one consumes the file
+class AquariumRegionStore {
+    public:
+        // 20 bytes on disk: type, speed, x, y, the heading quantized to int16, the phase, the grant, the pattern
+        static const int kRecordSize = 20;
+
+        // wipes whatever a previous session left in the directory
+        void Open(const std::string& directory, float regionSize);
+        bool IsOpen() const { return !m_directory.empty(); }
+        float GetRegionSize() const { return m_regionSize; }
+        void RegionOf(float x, float y, int& cx, int& cy) const;
+
+        void Evict(int cx, int cy, const std::vector<RegionCreatureRecord>& records);
+        bool HasStored(int cx, int cy) const;
+        // appends the stored creatures of the region to out and forgets them
+        bool Load(int cx, int cy, std::vector<RegionCreatureRecord>& out);
+        void Clear();
+
+        int GetStoredRegionCount() const { return m_stored.size(); }
+        long GetStoredCreatureCount() const;
+
+    private:
+        static long long keyFor(int cx, int cy);
+        std::string pathFor(int cx, int cy) const;
+
+        std::string m_directory;
+        float m_regionSize = 512.0f;
+        std::unordered_map<long long, int> m_stored; // region key -> records on disk
+};
@@ -0,0 +1,53 @@
+#include "AquariumTelemetry.h"
+
+#include <algorithm>
+
+
+AquariumTelemetry::AquariumTelemetry(){
+    for(int t = 0; t < kAquariumCreatureTypeCount; ++t){
+        m_creatures[t] = &m_registry.Gauge("aquarium_creatures", "Creatures in memory by type.",
+            "type=\"" + AquariumCreatureTypeToString(static_cast<AquariumCreatureType>(t)) + "\"");
+    }
+    for(int s = 0; s < int(MemorySubsystem::COUNT); ++s){
+        m_memory[s] = &m_registry.Gauge("aquarium_memory_bytes", "Live tracked memory by subsystem.",
+            "subsystem=\"" + MemorySubsystemToString(static_cast<MemorySubsystem>(s)) + "\"");
+    }
+    m_ticks = &m_registry.Counter("aquarium_ticks_total", "Simulation ticks run.");
+    m_level = &m_registry.Gauge("aquarium_level", "Index of the level being played.");
+    m_spawned = &m_registry.Counter("aquarium_spawned_total", "Creatures spawned by repopulation.");
+    m_removed = &m_registry.Counter("aquarium_removed_total", "Creatures eaten or otherwise removed.");
+    m_contacts = &m_registry.Counter("aquarium_contacts_total", "Creature vs creature contacts resolved.");
+    m_contactsPerTick = &m_registry.Gauge("aquarium_contacts_per_tick", "Contacts resolved per tick in the latest frame.");
+}
+
+void AquariumTelemetry::Start(const std::string& path, float periodSeconds){
+    m_exporter.Start(m_registry, path, periodSeconds);
+}
+
+void AquariumTelemetry::RecordTick(const Aquarium& aquarium, float tickMs){
+    if(!m_exporter.IsRunning()) return;
+    m_exporter.Record(FrameSample{tickMs, m_lastDrawMs});
+
+    const AquariumStats& stats = aquarium.getStats();
+    // counted from the tank, so a frame that ran more than one tick is not reported as one
+    long ticks = stats.ticks - m_lastStats.ticks;
+    m_ticks->Add(ticks);
+    m_level->Set(aquarium.getCurrentLevel());
+    m_spawned->Add(stats.spawned - m_lastStats.spawned);
+    m_removed->Add(stats.removed - m_lastStats.removed);
+    m_contacts->Add(stats.contacts - m_lastStats.contacts);
+    m_contactsPerTick->Set(double(stats.contacts - m_lastStats.contacts) / std::max(1L, ticks));
+    m_lastStats = stats;
+
+    // walking every creature is the one thing here that grows with the tank, so it runs less often
+    if(--m_censusCountdown <= 0){
+        m_censusCountdown = 30;
+        aquarium.CountByType(m_census);
+        for(int t = 0; t < kAquariumCreatureTypeCount; ++t){
+            m_creatures[t]->Set(m_census[t]);
+        }
+        for(int s = 0; s < int(MemorySubsystem::COUNT); ++s){
+            m_memory[s]->Set(MemoryLedger::Get(static_cast<MemorySubsystem>(s)).bytes);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Aquarium.h"
+#include "Metrics.h"
+
+
+// the metrics a running game publishes, see MetricsExporter for how they get to disk
+// the game thread only stores a handful of numbers per tick, the creature census runs
+// twice a second and everything else (percentiles, formatting, the file) is the exporter's
+class AquariumTelemetry {
+    public:
+        AquariumTelemetry();
+        // path is the .prom file a textfile collector scrapes
+        void Start(const std::string& path, float periodSeconds);
+        void Stop() { m_exporter.Stop(); }
+
+        // once per frame, tickMs covers every tick the frame ran
+        void RecordTick(const Aquarium& aquarium, float tickMs);
+        // timed in draw(), reported with the next tick
+        void RecordDraw(float drawMs) { m_lastDrawMs = drawMs; }
+
+    private:
+        MetricsRegistry m_registry; // declared first so the exporter thread stops before it goes away
+        MetricsExporter m_exporter;
+
+        std::array<Metric*, kAquariumCreatureTypeCount> m_creatures;
+        std::array<Metric*, int(MemorySubsystem::COUNT)> m_memory;
+        Metric* m_ticks;
+        Metric* m_level;
+        Metric* m_spawned;
+        Metric* m_removed;
+        Metric* m_contacts;
+        Metric* m_contactsPerTick;
+
+        AquariumStats m_lastStats;
+        float m_lastDrawMs = 0;
+        int m_censusCountdown = 0;
+        std::array<int, kAquariumCreatureTypeCount> m_census;
+};
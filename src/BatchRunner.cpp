@@ -0,0 +1,189 @@
+#include "BatchRunner.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+
+namespace {
+
+const int kBatchWindowWidth = 1024;
+const int kBatchWindowHeight = 768;
+const int kBatchWorldScale = 2;
+const int kBatchPlayerSpeed = 5;
+const float kTicksPerSecond = float(kAquariumTicksPerSecond);
+
+// the player steers with the same unit directions the arrow keys give
+void PickRandomDirection(PlayerCreature& player){
+    int dx = CreatureRandom() % 3 - 1;
+    int dy = CreatureRandom() % 3 - 1;
+    player.setDirection(dx, dy);
+}
+
+void SeekFood(Aquarium& aquarium, PlayerCreature& player, std::vector<std::shared_ptr<Creature>>& nearby){
+    aquarium.QueryRadius(player.getX(), player.getY(), 600, nearby);
+    float bestDist = 0;
+    std::shared_ptr<Creature> food;
+    float fleeX = 0, fleeY = 0;
+    for(const std::shared_ptr<Creature>& c : nearby){
+        float dx = c->getX() - player.getX();
+        float dy = c->getY() - player.getY();
+        float dist = dx * dx + dy * dy;
+        bool edible = std::static_pointer_cast<NPCreature>(c)->GetType() == AquariumCreatureType::PowerUp
+                   || c->getValue() <= player.getPower();
+        if(!edible){
+            // only the close threats matter, and the closer the stronger the push
+            if(dist < 200 * 200 && dist > 0){
+                fleeX -= dx / dist;
+                fleeY -= dy / dist;
+            }
+            continue;
+        }
+        if(!food || dist < bestDist){
+            food = c;
+            bestDist = dist;
+        }
+    }
+    if(fleeX != 0 || fleeY != 0){
+        player.setDirection(fleeX, fleeY);
+    } else if(food){
+        player.setDirection(food->getX() - player.getX(), food->getY() - player.getY());
+    } else {
+        // nothing in sight, head for the middle of the tank where the level spawns spread out from
+        player.setDirection(aquarium.getWidth() / 2 - player.getX(), aquarium.getHeight() / 2 - player.getY());
+    }
+}
+
+}
+
+
+string BatchPolicyToString(BatchPolicy p){
+    switch(p){
+        case BatchPolicy::RANDOM: return "random";
+        case BatchPolicy::SEEK: return "seek";
+        default: return "unknown";
+    }
+}
+
+bool BatchPolicyFromString(const string& name, BatchPolicy& out){
+    if(name == "random"){ out = BatchPolicy::RANDOM; return true; }
+    if(name == "seek"){ out = BatchPolicy::SEEK; return true; }
+    return false;
+}
+
+
+BatchSessionResult RunBatchSession(int session, const BatchConfig& config){
+    BatchSessionResult result;
+    result.session = session;
+    result.seed = config.baseSeed + session;
+    SeedCreatureRandom(result.seed);
+
+    int worldWidth = kBatchWindowWidth * kBatchWorldScale;
+    int worldHeight = kBatchWindowHeight * kBatchWorldScale;
+    auto aquarium = std::make_shared<Aquarium>(worldWidth, worldHeight, nullptr);
+    auto player = MakeTracked<MemorySubsystem::CREATURES, PlayerCreature>(worldWidth/2 - 50, worldHeight/2 - 50, kBatchPlayerSpeed, nullptr);
+    player->setDirection(0, 0);
+    AddDefaultAquariumLevels(aquarium);
+
+    // the real scene runs the rules, the policy only stands in for the keyboard
+    AquariumGameScene scene(player, aquarium, "batch");
+    scene.GetCamera().setViewport(kBatchWindowWidth, kBatchWindowHeight);
+    aquarium->Repopulate(); // after the scene so the first fish keep clear of the player
+
+    std::vector<std::shared_ptr<Creature>> nearby;
+    int startLives = player->getLives();
+    int level = aquarium->getCurrentLevel();
+    for(int tick = 0; tick < config.ticksPerSession; ++tick){
+        if(config.policy == BatchPolicy::RANDOM){
+            if(tick % kAquariumTicksPerSecond == 0) PickRandomDirection(*player);
+        } else if(tick % 6 == 0){
+            SeekFood(*aquarium, *player, nearby);
+        }
+
+        scene.Update();
+        result.ticks = tick + 1;
+
+        if(aquarium->getCurrentLevel() != level){
+            level = aquarium->getCurrentLevel();
+            ++result.levelsCompleted;
+            if(result.firstLevelTicks < 0) result.firstLevelTicks = tick + 1;
+        }
+        if(scene.GetLastEvent() != nullptr && scene.GetLastEvent()->isGameOver()){
+            result.gameOver = true;
+            break;
+        }
+    }
+    result.deaths = startLives - player->getLives();
+    result.score = player->getScore();
+    return result;
+}
+
+
+int RunBatch(const BatchConfig& config){
+    // a game's worth of notices per session would drown the report, and costs time
+    ofLogLevel previousLevel = ofGetLogLevel();
+    ofSetLogLevel(OF_LOG_WARNING);
+
+    int threads = config.threads > 0 ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<BatchSessionResult> results(config.sessions);
+    std::atomic<int> nextSession{0};
+
+    // workers pull the next session index until none are left, each writes only its own result slot
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for(int t = 0; t < threads; ++t){
+        pool.emplace_back([&](){
+            for(int s = nextSession++; s < config.sessions; s = nextSession++){
+                results[s] = RunBatchSession(s, config);
+            }
+        });
+    }
+    for(std::thread& worker : pool){
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ofSetLogLevel(previousLevel);
+
+    if(!config.csvPath.empty()){
+        std::ofstream csv(config.csvPath);
+        csv << "session,seed,policy,ticks,levels_completed,first_level_seconds,deaths,score,score_per_minute,game_over\n";
+        for(const BatchSessionResult& r : results){
+            float minutes = r.ticks / kTicksPerSecond / 60.0f;
+            csv << r.session << ',' << r.seed << ',' << BatchPolicyToString(config.policy) << ',' << r.ticks << ','
+                << r.levelsCompleted << ','
+                << (r.firstLevelTicks < 0 ? -1.0f : r.firstLevelTicks / kTicksPerSecond) << ','
+                << r.deaths << ',' << r.score << ',' << (minutes > 0 ? r.score / minutes : 0) << ','
+                << (r.gameOver ? 1 : 0) << '\n';
+        }
+        if(!csv){
+            ofLogError() << "failed to write " << config.csvPath << std::endl;
+        }
+    }
+
+    // aggregate row, the same columns a spreadsheet over the csv would give
+    long totalTicks = 0, totalDeaths = 0, totalScore = 0, totalLevels = 0, gameOvers = 0, firstLevelTicks = 0;
+    int completedOne = 0;
+    for(const BatchSessionResult& r : results){
+        totalTicks += r.ticks;
+        totalDeaths += r.deaths;
+        totalScore += r.score;
+        totalLevels += r.levelsCompleted;
+        gameOvers += r.gameOver ? 1 : 0;
+        if(r.firstLevelTicks >= 0){
+            firstLevelTicks += r.firstLevelTicks;
+            ++completedOne;
+        }
+    }
+    int n = std::max(1, config.sessions);
+    float minutes = totalTicks / kTicksPerSecond / 60.0f;
+    std::printf("policy,sessions,threads,sessions_per_second,mean_levels,mean_first_level_seconds,mean_deaths,score_per_minute,game_over_rate\n");
+    std::printf("%s,%d,%d,%.2f,%.3f,%.2f,%.3f,%.3f,%.3f\n",
+        BatchPolicyToString(config.policy).c_str(), config.sessions, threads, config.sessions / std::max(seconds, 1e-9),
+        double(totalLevels) / n,
+        completedOne > 0 ? firstLevelTicks / kTicksPerSecond / completedOne : -1.0,
+        double(totalDeaths) / n,
+        minutes > 0 ? totalScore / minutes : 0.0,
+        double(gameOvers) / n);
+    return 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Aquarium.h"
+
+
+// how a headless session steers its player
+enum class BatchPolicy {
+    RANDOM, // wanders in a random direction, changing it every second or so
+    SEEK    // swims to the closest thing it can eat and away from what it cannot
+};
+
+string BatchPolicyToString(BatchPolicy p);
+bool BatchPolicyFromString(const string& name, BatchPolicy& out);
+
+struct BatchSessionResult {
+    int session = 0;
+    unsigned seed = 0;
+    int ticks = 0;              // ticks simulated before the game ended or the budget ran out
+    int levelsCompleted = 0;
+    int firstLevelTicks = -1;   // ticks until the first level was completed, -1 if it never was
+    int deaths = 0;
+    int score = 0;
+    bool gameOver = false;
+};
+
+struct BatchConfig {
+    int sessions = 1000;
+    int ticksPerSession = 3 * 60 * kAquariumTicksPerSecond; // three minutes of game time
+    BatchPolicy policy = BatchPolicy::SEEK;
+    int threads = 0;                   // 0 picks one per core
+    unsigned baseSeed = 4010;
+    string csvPath;                    // empty skips the per session csv
+};
+
+// runs one full game (player, aquarium and the default levels) without a window
+BatchSessionResult RunBatchSession(int session, const BatchConfig& config);
+
+// runs config.sessions independent sessions on a pool of worker threads, writes one csv row
+// per session and prints aggregate stats plus the throughput in sessions per second
+int RunBatch(const BatchConfig& config);
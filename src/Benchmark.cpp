@@ -0,0 +1,564 @@
+#include "Benchmark.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <thread>
+#include "SnapshotNet.h"
+
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+const int kBenchWidth = 4096;
+const int kBenchHeight = 3072;
+const WorldBounds kBenchWorld{float(kBenchWidth), float(kBenchHeight), 0};
+
+enum class BenchLayout {
+    UNIFORM,
+    BANDED
+};
+
+const char* BenchLayoutToString(BenchLayout layout){
+    return layout == BenchLayout::UNIFORM ? "uniform" : "banded";
+}
+
+// same mix of fish the levels use, without sprites
+std::vector<std::shared_ptr<Creature>> MakeBenchCreatures(int count, BenchLayout layout, unsigned seed){
+    std::mt19937 rng(seed);
+    SeedCreatureRandom(seed); // creature constructors pick their heading at random
+    std::uniform_real_distribution<float> xDist(0, kBenchWidth);
+    std::uniform_real_distribution<float> yDist(0, kBenchHeight);
+    std::uniform_int_distribution<int> speedDist(1, 5);
+    std::normal_distribution<float> bandSpread(0, 25);
+    const int bands = 6;
+
+    std::vector<std::shared_ptr<Creature>> creatures;
+    creatures.reserve(count);
+    for(int i = 0; i < count; ++i){
+        float x = xDist(rng);
+        float y = yDist(rng);
+        if(layout == BenchLayout::BANDED){
+            // jellyfish drift sideways and bob in place, so they pile up in horizontal bands
+            float bandY = (i % bands + 0.5f) * kBenchHeight / bands;
+            y = ofClamp(bandY + bandSpread(rng), 0, kBenchHeight);
+        }
+        std::shared_ptr<NPCreature> c;
+        switch(i % 4){
+            case 0: c = std::make_shared<BiggerFish>(x, y, speedDist(rng), nullptr); break;
+            case 1: c = std::make_shared<JellyFish>(x, y, speedDist(rng), nullptr); break;
+            case 2: c = std::make_shared<FastFish>(x, y, speedDist(rng), nullptr); break;
+            default: c = std::make_shared<NPCreature>(x, y, speedDist(rng), nullptr); break;
+        }
+        creatures.push_back(c);
+    }
+    return creatures;
+}
+
+// a patrolling script, wakes up every so often, does a little work and goes back to sleep
+ScriptTask BenchPatrol(ScriptScheduler& scripts, uint32_t period, long long& work){
+    for(;;){
+        co_await scripts.Ticks(period);
+        ++work;
+    }
+}
+
+// one that waits for something that never happens in the benchmark
+ScriptTask BenchWaitForBoss(ScriptScheduler& scripts, long long& work){
+    co_await scripts.Signal(ScriptSignal::BOSS_DEFEATED);
+    ++work;
+}
+
+struct BroadphaseRun {
+    double msPerTick = 0;
+    long long contacts = 0;
+    long long candidates = 0;
+};
+
+// every tick moves the fish and collects every swept contact, like a full collision pass would
+BroadphaseRun RunBroadphase(BroadphaseKind kind, int count, BenchLayout layout, int ticks){
+    std::vector<std::shared_ptr<Creature>> creatures = MakeBenchCreatures(count, layout, 4010);
+    std::unique_ptr<Broadphase> broadphase = MakeBroadphase(kind);
+    BroadphaseRun run;
+    double totalMs = 0;
+    for(int t = 0; t < ticks; ++t){
+        for(auto& c : creatures){
+            c->move(kBenchWorld);
+        }
+        auto start = BenchClock::now();
+        broadphase->ForEachCandidatePair(creatures, [&](int i, int j){
+            ++run.candidates;
+            if(checkSweptCollision(creatures[i], creatures[j])) ++run.contacts;
+            return false;
+        });
+        totalMs += std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+        for(auto& c : creatures){
+            c->markCollisionCheckpoint();
+        }
+    }
+    run.msPerTick = totalMs / ticks;
+    return run;
+}
+
+}
+
+
+int RunBroadphaseBenchmark(){
+    const int ticks = 60;
+    const int populations[] = {250, 1000, 4000};
+    const BenchLayout layouts[] = {BenchLayout::UNIFORM, BenchLayout::BANDED};
+
+    std::printf("%-8s %6s %-16s %10s %12s %10s\n", "layout", "fish", "broadphase", "ms/tick", "candidates", "contacts");
+    for(BenchLayout layout : layouts){
+        for(int count : populations){
+            BroadphaseRun brute = RunBroadphase(BroadphaseKind::BRUTE_FORCE, count, layout, ticks);
+            BroadphaseRun sap = RunBroadphase(BroadphaseKind::SWEEP_AND_PRUNE, count, layout, ticks);
+            std::printf("%-8s %6d %-16s %10.3f %12lld %10lld\n", BenchLayoutToString(layout), count,
+                "BRUTE_FORCE", brute.msPerTick, brute.candidates / ticks, brute.contacts / ticks);
+            std::printf("%-8s %6d %-16s %10.3f %12lld %10lld\n", BenchLayoutToString(layout), count,
+                "SWEEP_AND_PRUNE", sap.msPerTick, sap.candidates / ticks, sap.contacts / ticks);
+            if(brute.contacts != sap.contacts){
+                std::printf("  contact counts differ, sweep and prune is missing pairs!\n");
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+
+int RunSchoolingBenchmark(){
+    const int ticks = 120;
+    const int populations[] = {1000, 2500, 5000, 10000, 20000};
+
+    std::printf("%6s %12s %14s %14s\n", "fish", "tank", "update ms", "schooling ms");
+    for(int count : populations){
+        // keep the density of a crowded level, about one fish per 150x150 patch
+        int side = int(std::sqrt(float(count)) * 150);
+        Aquarium aquarium(side, side, nullptr);
+        std::mt19937 rng(4010);
+        SeedCreatureRandom(4010);
+        std::uniform_real_distribution<float> pos(0, side);
+        std::uniform_int_distribution<int> speedDist(1, 5);
+        for(int i = 0; i < count; ++i){
+            if(i % 3 == 0){
+                aquarium.addCreature(std::make_shared<FastFish>(pos(rng), pos(rng), speedDist(rng), nullptr));
+            } else {
+                aquarium.addCreature(std::make_shared<NPCreature>(pos(rng), pos(rng), speedDist(rng), nullptr));
+            }
+        }
+
+        // the same ticks with schooling off tell how much of the update it costs
+        double plainMs = 0, schoolMs = 0;
+        for(int pass = 0; pass < 2; ++pass){
+            aquarium.setSchoolingEnabled(pass == 1);
+            auto start = BenchClock::now();
+            for(int t = 0; t < ticks; ++t){
+                aquarium.update();
+            }
+            double ms = std::chrono::duration<double, std::milli>(BenchClock::now() - start).count() / ticks;
+            (pass == 0 ? plainMs : schoolMs) = ms;
+        }
+        std::printf("%6d %6dx%-6d %14.3f %14.3f\n", count, side, side, schoolMs, schoolMs - plainMs);
+    }
+    return 0;
+}
+
+
+int RunSpawnBenchmark(){
+    const int batches = 10;
+    const int batchSizes[] = {500, 2000, 5000};
+    const AquariumCreatureType mix[] = {
+        AquariumCreatureType::NPCreature, AquariumCreatureType::FastFish,
+        AquariumCreatureType::JellyFish, AquariumCreatureType::BiggerFish
+    };
+
+    std::printf("%6s %8s %12s %12s %12s\n", "batch", "in tank", "ms/batch", "fallbacks", "overlapping");
+    for(int batchSize : batchSizes){
+        // big enough that the last batch still has room, a full tank only tests the fallback
+        int side = int(std::sqrt(float(batchSize * batches)) * 120);
+        Aquarium aquarium(side, side, nullptr);
+        SeedCreatureRandom(4010);
+        aquarium.addSpawnSafeZone(side / 2, side / 2, 250);
+        std::vector<AquariumCreatureType> types(batchSize);
+        for(int i = 0; i < batchSize; ++i){
+            types[i] = mix[i % 4];
+        }
+
+        double totalMs = 0;
+        long fallbacks = 0;
+        for(int b = 0; b < batches; ++b){
+            auto start = BenchClock::now();
+            aquarium.SpawnCreatures(types);
+            totalMs += std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+            fallbacks += aquarium.getLastSpawnFallbacks();
+        }
+
+        // every creature that touches another one, found through the index
+        const std::vector<std::shared_ptr<Creature>>& creatures = aquarium.getCreatures();
+        std::vector<int> touching;
+        long overlapping = 0;
+        for(int i = 0; i < int(creatures.size()); ++i){
+            const Creature& c = *creatures[i];
+            aquarium.getSpatialIndex().QueryRadius(c.getX(), c.getY(), c.getCollisionRadius(), touching);
+            if(touching.size() > 1) ++overlapping;
+        }
+        std::printf("%6d %8d %12.3f %12ld %12ld\n", batchSize, aquarium.getCreatureCount(),
+            totalMs / batches, fallbacks, overlapping);
+    }
+    return 0;
+}
+
+
+int RunContactBenchmark(){
+    const int ticks = 60;
+    const int populations[] = {250, 1000, 4000};
+    const int budgets[] = {1, 4, 8};
+
+    // the broadphase switch logs a notice for every run
+    ofLogLevel previousLevel = ofGetLogLevel();
+    ofSetLogLevel(OF_LOG_WARNING);
+    std::printf("%6s %10s %10s %10s %14s %14s\n", "fish", "iterations", "ms/tick", "contacts", "mean residual", "last residual");
+    for(int count : populations){
+        for(int iterations : budgets){
+            // everyone starts piled up in a disk about as big as the fish themselves, so it is full of overlaps
+            int side = int(std::sqrt(float(count)) * 150);
+            Aquarium aquarium(side, side, nullptr);
+            std::mt19937 rng(4010);
+            SeedCreatureRandom(4010);
+            std::uniform_real_distribution<float> angle(0, TWO_PI);
+            std::uniform_real_distribution<float> unit(0, 1);
+            float pileRadius = std::sqrt(float(count)) * 55;
+            for(int i = 0; i < count; ++i){
+                float a = angle(rng);
+                float r = pileRadius * std::sqrt(unit(rng));
+                float x = side / 2 + std::cos(a) * r;
+                float y = side / 2 + std::sin(a) * r;
+                if(i % 2 == 0){
+                    aquarium.addCreature(std::make_shared<BiggerFish>(x, y, 1 + i % 5, nullptr));
+                } else {
+                    aquarium.addCreature(std::make_shared<NPCreature>(x, y, 1 + i % 5, nullptr));
+                }
+            }
+            aquarium.setBroadphase(BroadphaseKind::SWEEP_AND_PRUNE);
+            aquarium.markCollisionCheckpoint();
+
+            double totalMs = 0, residual = 0;
+            long contacts = 0;
+            for(int t = 0; t < ticks; ++t){
+                aquarium.update();
+                auto start = BenchClock::now();
+                contacts += aquarium.ResolveContacts(iterations);
+                totalMs += std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+                residual += aquarium.getContactSolver().GetResidualPenetration();
+                aquarium.markCollisionCheckpoint();
+            }
+            std::printf("%6d %10d %10.3f %10ld %14.2f %14.2f\n", count, iterations, totalMs / ticks,
+                contacts / ticks, residual / ticks, aquarium.getContactSolver().GetResidualPenetration());
+        }
+    }
+    ofSetLogLevel(previousLevel);
+    return 0;
+}
+
+
+int RunMemoryReport(int creatures){
+    ofLogLevel previousLevel = ofGetLogLevel();
+    ofSetLogLevel(OF_LOG_WARNING);
+    SeedCreatureRandom(4010);
+    {
+        int side = int(std::sqrt(float(std::max(1, creatures))) * 150);
+        auto aquarium = std::make_shared<Aquarium>(side, side, nullptr);
+        auto player = MakeTracked<MemorySubsystem::CREATURES, PlayerCreature>(side / 2, side / 2, 5, nullptr);
+        aquarium->setBroadphase(BroadphaseKind::SWEEP_AND_PRUNE); // big tanks would crawl brute force
+        AddDefaultAquariumLevels(aquarium);
+        AquariumGameScene scene(player, aquarium, "memory");
+        std::vector<AquariumCreatureType> types(creatures);
+        for(int i = 0; i < creatures; ++i){
+            types[i] = static_cast<AquariumCreatureType>(i % 4);
+        }
+        aquarium->SpawnCreatures(types);
+        for(int t = 0; t < 60 * kAquariumTicksPerSecond; ++t){
+            scene.Update();
+        }
+
+        std::printf("%d creatures in a %dx%d tank after a minute\n", aquarium->getCreatureCount(), side, side);
+        std::ostringstream report;
+        MemoryLedger::WriteReport(report);
+        std::printf("%s", report.str().c_str());
+
+        // one shared image per type, on the CPU and as a texture, plus the atlas of their frames on the GPU
+        // none of it grows with the number of creatures
+        std::vector<SpriteSource> sources;
+        double spriteBytes = 0;
+        for(int t = 0; t < kAquariumCreatureTypeCount; ++t){
+            auto type = static_cast<AquariumCreatureType>(t);
+            int sideLength = AquariumSpriteManager::GetSpriteSide(type);
+            spriteBytes += double(sideLength) * sideLength * 4 * 2;
+            sources.push_back(SpriteSource{nullptr, sideLength, sideLength, AquariumSpriteManager::GetAnimation(type)});
+        }
+        SpriteAtlas atlas;
+        atlas.Layout(sources);
+        spriteBytes += atlas.GetBytes();
+        std::printf("%-10s %12.1f   (projected, sprites do not load headless)\n", "sprites", spriteBytes / 1024.0);
+    }
+    ofSetLogLevel(previousLevel);
+    return 0;
+}
+
+
+int RunEcosystemBenchmark(){
+    const int ticks = 300;
+    const int populations[] = {5000, 10000, 20000};
+    const double frameBudgetMs = 1000.0 / 60.0;
+
+    std::printf("%6s %14s %14s %12s %8s\n", "fish", "update ms", "ecosystem ms", "eaten/sec", "budget");
+    for(int count : populations){
+        // same density as the schooling benchmark, two small fish per predator
+        int side = int(std::sqrt(float(count)) * 150);
+        Aquarium aquarium(side, side, nullptr);
+        std::mt19937 rng(4010);
+        SeedCreatureRandom(4010);
+        std::uniform_real_distribution<float> pos(0, side);
+        std::uniform_int_distribution<int> speedDist(1, 5);
+        auto spawn = [&](AquariumCreatureType type){
+            float x = pos(rng), y = pos(rng);
+            switch(type){
+                case AquariumCreatureType::BiggerFish: aquarium.addCreature(std::make_shared<BiggerFish>(x, y, speedDist(rng), nullptr)); break;
+                case AquariumCreatureType::JellyFish: aquarium.addCreature(std::make_shared<JellyFish>(x, y, speedDist(rng), nullptr)); break;
+                case AquariumCreatureType::FastFish: aquarium.addCreature(std::make_shared<FastFish>(x, y, speedDist(rng), nullptr)); break;
+                default: aquarium.addCreature(std::make_shared<NPCreature>(x, y, speedDist(rng), nullptr)); break;
+            }
+        };
+        std::array<int, kAquariumCreatureTypeCount> wanted{};
+        for(int i = 0; i < count; ++i){
+            AquariumCreatureType type = AquariumCreatureType::NPCreature;
+            switch(i % 6){
+                case 0: type = AquariumCreatureType::BiggerFish; break;
+                case 1: type = AquariumCreatureType::JellyFish; break;
+                case 2: case 3: type = AquariumCreatureType::FastFish; break;
+            }
+            ++wanted[int(type)];
+            spawn(type);
+        }
+        aquarium.setEcosystemEnabled(true);
+
+        // there are no levels to repopulate the tank, so the eaten are put back between ticks
+        // (outside the timing) and every tick hunts over the same number of fish
+        std::array<int, kAquariumCreatureTypeCount> census{};
+        double updateMs = 0;
+        double ecosystemMs = 0;
+        for(int t = 0; t < ticks; ++t){
+            auto start = BenchClock::now();
+            aquarium.update();
+            updateMs += std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+            ecosystemMs += aquarium.getLastEcosystemUs() / 1000.0;
+            aquarium.CountByType(census);
+            for(int type = 0; type < kAquariumCreatureTypeCount; ++type){
+                for(int n = census[type]; n < wanted[type]; ++n){
+                    spawn(AquariumCreatureType(type));
+                }
+            }
+        }
+        updateMs /= ticks;
+        ecosystemMs /= ticks;
+        long eaten = aquarium.getStats().preyEaten;
+        std::printf("%6d %14.3f %14.3f %12.1f %8s\n", count, updateMs, ecosystemMs,
+            eaten / (double(ticks) / kAquariumTicksPerSecond), updateMs * kAquariumTicksPerFrame < frameBudgetMs ? "ok" : "over");
+    }
+    return 0;
+}
+
+
+int RunScriptBenchmark(){
+    const int ticks = 600;
+    const int counts[] = {1000, 10000, 100000};
+    std::printf("%8s %12s %14s %14s\n", "scripts", "tick us", "resumed/tick", "us/resume");
+    for(int count : counts){
+        ScriptScheduler scripts;
+        std::mt19937 rng(4010);
+        std::uniform_int_distribution<uint32_t> period(kAquariumTicksPerSecond, 20 * kAquariumTicksPerSecond); // one to twenty seconds
+        long long work = 0;
+        for(int i = 0; i < count; ++i){
+            // a tenth sit on a signal the whole time, the rest patrol
+            if(i % 10 == 0) scripts.Start(BenchWaitForBoss(scripts, work));
+            else scripts.Start(BenchPatrol(scripts, period(rng), work));
+        }
+        scripts.Tick(); // everyone runs to their first wait
+        long long resumed = 0;
+        auto start = BenchClock::now();
+        for(int t = 0; t < ticks; ++t){
+            scripts.Tick();
+            resumed += scripts.GetLastResumedCount();
+        }
+        double us = std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+        std::printf("%8d %12.2f %14.1f %14.3f\n", count, us / ticks, double(resumed) / ticks,
+            resumed > 0 ? us / resumed : 0.0);
+    }
+    return 0;
+}
+
+
+int RunEffectBenchmark(){
+    const int ticks = 1200;
+    const int counts[] = {100, 1000, 10000};
+    std::printf("%8s %10s %12s %16s %16s\n", "effects", "creatures", "tick us", "expired/tick", "visited/tick");
+    for(int count : counts){
+        // a few effects per creature, like a crowd that keeps running into power ups
+        int creatureCount = std::max(1, count / 3);
+        std::vector<std::shared_ptr<NPCreature>> creatures;
+        for(int i = 0; i < creatureCount; ++i){
+            creatures.push_back(std::make_shared<NPCreature>(0, 0, 1, nullptr));
+        }
+        EffectSystem effects;
+        std::mt19937 rng(4700);
+        std::uniform_int_distribution<int> kind(0, int(EffectKind::COUNT) - 1);
+        std::uniform_int_distribution<uint32_t> duration(kAquariumTicksPerSecond, 30 * kAquariumTicksPerSecond); // one to thirty seconds
+        std::uniform_int_distribution<int> who(0, creatureCount - 1);
+        auto grantOne = [&](){
+            EffectGrant grant{EffectKind(kind(rng)), 1.5f, duration(rng)};
+            effects.Apply(*creatures[who(rng)], grant);
+        };
+        while(effects.GetActiveCount() < count) grantOne();
+
+        // whatever runs out is handed out again, so the count holds steady
+        long long expired = 0, visited = 0;
+        auto start = BenchClock::now();
+        for(int t = 0; t < ticks; ++t){
+            effects.Tick();
+            expired += effects.GetLastExpiredCount();
+            visited += effects.GetLastVisitedCount();
+            while(effects.GetActiveCount() < count) grantOne();
+        }
+        double us = std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+        std::printf("%8d %10d %12.2f %16.2f %16.2f\n", count, creatureCount, us / ticks,
+            double(expired) / ticks, double(visited) / ticks);
+    }
+    return 0;
+}
+
+
+int RunPlayerCollisionBenchmark(){
+    const int rounds = 200;
+    const int creatureCounts[] = {2000, 10000};
+    const int playerCounts[] = {1, 4, 16, 64};
+    int mismatches = 0;
+    std::printf("%9s %8s %14s %14s\n", "creatures", "players", "batched us", "every pair us");
+    for(int count : creatureCounts){
+        Aquarium aquarium(kBenchWidth, kBenchHeight, nullptr);
+        for(const std::shared_ptr<Creature>& c : MakeBenchCreatures(count, BenchLayout::UNIFORM, 4800)){
+            aquarium.addCreature(c);
+        }
+        std::mt19937 rng(4801);
+        std::uniform_real_distribution<float> xDist(0, kBenchWidth);
+        std::uniform_real_distribution<float> yDist(0, kBenchHeight);
+        for(int playerCount : playerCounts){
+            std::vector<std::shared_ptr<PlayerCreature>> players;
+            for(int p = 0; p < playerCount; ++p){
+                players.push_back(std::make_shared<PlayerCreature>(xDist(rng), yDist(rng), 5, nullptr));
+            }
+            // the index is rebuilt every round, like after a tick where everyone moved
+            std::vector<std::shared_ptr<GameEvent>> hits;
+            std::vector<int> nearby;
+            long found = 0;
+            auto start = BenchClock::now();
+            for(int r = 0; r < rounds; ++r){
+                aquarium.markCollisionCheckpoint();
+                DetectAquariumCollisions(aquarium, players, hits, nearby);
+                found += hits.size();
+            }
+            double batched = std::chrono::duration<double, std::micro>(BenchClock::now() - start).count() / rounds;
+
+            // what one player at a time against the whole tank would cost
+            long naiveFound = 0;
+            start = BenchClock::now();
+            for(int r = 0; r < rounds; ++r){
+                for(const std::shared_ptr<PlayerCreature>& player : players){
+                    for(const std::shared_ptr<Creature>& c : aquarium.getCreatures()){
+                        if(checkSweptCollision(player, c)) ++naiveFound;
+                    }
+                }
+            }
+            double naive = std::chrono::duration<double, std::micro>(BenchClock::now() - start).count() / rounds;
+            if(found != naiveFound){
+                std::printf("hits differ: %ld batched, %ld every pair\n", found, naiveFound);
+                ++mismatches;
+            }
+            std::printf("%9d %8d %14.1f %14.1f\n", count, playerCount, batched, naive);
+        }
+    }
+    return mismatches > 0 ? 1 : 0;
+}
+
+
+int RunSnapshotBenchmark(){
+    const int creatures = 1000;
+    const int ticks = 600;
+    const int ticksPerSnapshot = kAquariumTicksPerSecond / 30; // what --serve sends
+    const int clientCounts[] = {1, 4, 16};
+    ofLogLevel previousLevel = ofGetLogLevel();
+    ofSetLogLevel(OF_LOG_WARNING); // joins and leaves
+    std::printf("%7s %10s %14s %14s %16s %14s %10s\n", "clients", "full B", "delta B/snap", "kB/s/client",
+        "server us/client", "decode us", "mismatch");
+    int totalMismatches = 0;
+    for(int clientCount : clientCounts){
+        int mismatches = 0;
+        Aquarium aquarium(kBenchWidth, kBenchHeight, nullptr);
+        for(const std::shared_ptr<Creature>& c : MakeBenchCreatures(creatures, BenchLayout::UNIFORM, 4900)){
+            aquarium.addCreature(c);
+        }
+        std::vector<std::shared_ptr<PlayerCreature>> players;
+        SnapshotServer server;
+        // whatever port is free, a fixed one fails on a box where something else holds it
+        if(!server.Open(0, kBenchWidth, kBenchHeight, 0, ticksPerSnapshot)) return 1;
+        std::vector<std::unique_ptr<SnapshotClient>> clients;
+        for(int i = 0; i < clientCount; ++i){
+            clients.push_back(std::make_unique<SnapshotClient>());
+            if(!clients.back()->Connect(server.GetPort())) return 1;
+        }
+        InputQueue input;
+        while(server.GetClientCount() < clientCount) server.Poll(input);
+
+        // every snapshot is waited for on every client, so the acks keep up like on a quiet network
+        Snapshot snapshot;
+        double serverUs = 0;
+        int sent = 0;
+        size_t fullBytes = 0;
+        for(int t = 0; t < ticks; ++t){
+            aquarium.update();
+            if(t % ticksPerSnapshot != 0) continue;
+            CaptureSnapshot(aquarium, players, t + 1, snapshot);
+            auto start = BenchClock::now();
+            server.Broadcast(snapshot);
+            serverUs += std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+            ++sent;
+            for(auto& client : clients){
+                auto waited = BenchClock::now();
+                while(client->Poll() && client->GetSnapshotCount() < uint64_t(sent)
+                      && BenchClock::now() - waited < std::chrono::seconds(1)){
+                    std::this_thread::yield();
+                }
+                const Snapshot* got = client->GetHistory().Latest();
+                if(got == nullptr || got->tick != snapshot.tick || got->entities != snapshot.entities) ++mismatches;
+            }
+            if(sent == 1) fullBytes = clients[0]->GetBytesReceived();
+            server.Poll(input);
+        }
+
+        uint64_t bytes = 0;
+        double decodeUs = 0;
+        for(auto& client : clients){
+            bytes += client->GetBytesReceived();
+            decodeUs += client->GetDecodeUs() / std::max<uint64_t>(1, client->GetSnapshotCount());
+        }
+        // the hello and the first full snapshot are left out of the steady state figures
+        double deltaBytes = double(bytes - fullBytes * clientCount) / clientCount / std::max(1, sent - 1);
+        float seconds = ticks / float(kAquariumTicksPerSecond);
+        std::printf("%7d %10zu %14.1f %14.2f %16.2f %14.2f %10d\n", clientCount, fullBytes, deltaBytes,
+            bytes / 1024.0 / clientCount / seconds, serverUs / sent / clientCount, decodeUs / clientCount, mismatches);
+        totalMismatches += mismatches;
+    }
+    ofSetLogLevel(previousLevel);
+    return totalMismatches > 0 ? 1 : 0;
+}
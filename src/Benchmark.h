@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Aquarium.h"
+
+
+// headless benchmarks, these run from main() before any window exists
+// so they only use creatures without sprites
+
+// brute force vs sweep and prune on uniform and banded (jellyfish like) layouts
+int RunBroadphaseBenchmark();
+
+// cost of one schooling tick as the school grows
+int RunSchoolingBenchmark();
+
+// bulk spawn batches into a filling tank, time per batch and how many spawns overlapped
+int RunSpawnBenchmark();
+
+// a tight pile of fish solved with different iteration budgets, cost and leftover overlap
+int RunContactBenchmark();
+
+// memory by subsystem for a tank of the given size after a minute of play, plus what the
+// sprites would add with a window (they cannot load headless)
+int RunMemoryReport(int creatures);
+
+// update cost with the food web on, up to 20k creatures, the ticks of a frame against the 60 Hz frame budget
+// the eaten are respawned between ticks so the population stays where it started
+int RunEcosystemBenchmark();
+
+// thousands of level scripts at once, tick cost with most of them asleep
+int RunScriptBenchmark();
+
+// timed effects running out through the wheel, tick cost against how many run out per tick
+int RunEffectBenchmark();
+
+// player vs tank collision checks for many players at once, against testing every pair
+// non zero if the two ever find a different number of hits
+int RunPlayerCollisionBenchmark();
+
+// delta snapshots to 1, 4 and 16 loopback clients from a tank of 1000 fish, bytes and time per client
+// non zero if a client ever decodes a snapshot different from the one sent
+int RunSnapshotBenchmark();
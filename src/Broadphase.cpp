@@ -0,0 +1,205 @@
+#include "Broadphase.h"
+
+
+string BroadphaseKindToString(BroadphaseKind k){
+    switch(k){
+        case BroadphaseKind::BRUTE_FORCE:
+            return "BRUTE_FORCE";
+        case BroadphaseKind::SWEEP_AND_PRUNE:
+            return "SWEEP_AND_PRUNE";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+std::unique_ptr<Broadphase> MakeBroadphase(BroadphaseKind kind){
+    switch(kind){
+        case BroadphaseKind::SWEEP_AND_PRUNE:
+            return std::make_unique<SweepAndPruneBroadphase>();
+        case BroadphaseKind::BRUTE_FORCE:
+        default:
+            return std::make_unique<BruteForceBroadphase>();
+    }
+}
+
+
+void BruteForceBroadphase::ForEachCandidatePair(const std::vector<std::shared_ptr<Creature>>& creatures, const BroadphasePairVisitor& visit){
+    int count = creatures.size();
+    for (int i = 0; i < count; ++i){
+        for (int j = i + 1; j < count; ++j){
+            if (visit(i, j)) return;
+        }
+    }
+}
+
+
+// the box covers the whole sweep since the last checkpoint, not just the current position
+void SweepAndPruneBroadphase::fitBounds(SweepEntry& e, const Creature& c){
+    float r = c.getCollisionRadius() + c.getSweepReach();
+    e.minX = c.getX() - r;
+    e.maxX = c.getX() + r;
+    e.minY = c.getY() - r;
+    e.maxY = c.getY() + r;
+}
+
+void SweepAndPruneBroadphase::sync(const std::vector<std::shared_ptr<Creature>>& creatures){
+    int count = creatures.size();
+    m_lookup.clear();
+    for (int i = 0; i < count; ++i){
+        m_lookup[creatures[i].get()] = i;
+    }
+    m_seen.assign(count, 0);
+
+    // drop the creatures that left the tank and refresh the rest, keeping last frame's order
+    size_t kept = 0;
+    for (size_t k = 0; k < m_entries.size(); ++k){
+        SweepEntry e = m_entries[k];
+        auto found = m_lookup.find(e.creature);
+        if (found == m_lookup.end() || m_seen[found->second]) continue;
+        e.index = found->second;
+        m_seen[e.index] = 1;
+        fitBounds(e, *creatures[e.index]);
+        m_entries[kept++] = e;
+    }
+    m_entries.resize(kept);
+
+    // newcomers go at the end, the insertion sort walks them into place
+    for (int i = 0; i < count; ++i){
+        if (m_seen[i]) continue;
+        SweepEntry e{creatures[i].get(), i, 0, 0, 0, 0};
+        fitBounds(e, *creatures[i]);
+        m_entries.push_back(e);
+    }
+
+    m_lastSwaps = 0;
+    for (size_t k = 1; k < m_entries.size(); ++k){
+        SweepEntry e = m_entries[k];
+        size_t j = k;
+        while (j > 0 && m_entries[j - 1].minX > e.minX){
+            m_entries[j] = m_entries[j - 1];
+            --j;
+            ++m_lastSwaps;
+        }
+        m_entries[j] = e;
+    }
+}
+
+void SweepAndPruneBroadphase::ForEachCandidatePair(const std::vector<std::shared_ptr<Creature>>& creatures, const BroadphasePairVisitor& visit){
+    this->sync(creatures);
+    size_t count = m_entries.size();
+    for (size_t i = 0; i < count; ++i){
+        const SweepEntry& a = m_entries[i];
+        // sorted by minX, so once b starts past a's right edge nobody after it can overlap a
+        for (size_t j = i + 1; j < count && m_entries[j].minX <= a.maxX; ++j){
+            const SweepEntry& b = m_entries[j];
+            if (a.maxY < b.minY || b.maxY < a.minY) continue;
+            if (visit(std::min(a.index, b.index), std::max(a.index, b.index))) return;
+        }
+    }
+}
+
+
+int SpatialGrid::cellX(float x) const {
+    int cx = int((x - m_originX) / m_cellSize);
+    return std::min(std::max(cx, 0), m_cols - 1);
+}
+
+int SpatialGrid::cellY(float y) const {
+    int cy = int((y - m_originY) / m_cellSize);
+    return std::min(std::max(cy, 0), m_rows - 1);
+}
+
+void SpatialGrid::Build(const std::vector<std::shared_ptr<Creature>>& creatures, float cellSize){
+    int count = creatures.size();
+    m_x.resize(count);
+    m_y.resize(count);
+    m_r.resize(count);
+    m_cellOf.resize(count);
+    m_maxRadius = 0;
+    m_maxSweep = 0;
+
+    float minX = 0, minY = 0, maxX = 0, maxY = 0;
+    for (int i = 0; i < count; ++i){
+        const Creature& c = *creatures[i];
+        m_x[i] = c.getX();
+        m_y[i] = c.getY();
+        m_r[i] = c.getCollisionRadius();
+        m_maxRadius = std::max(m_maxRadius, m_r[i]);
+        m_maxSweep = std::max(m_maxSweep, c.getSweepReach());
+        if (i == 0 || m_x[i] < minX) minX = m_x[i];
+        if (i == 0 || m_x[i] > maxX) maxX = m_x[i];
+        if (i == 0 || m_y[i] < minY) minY = m_y[i];
+        if (i == 0 || m_y[i] > maxY) maxY = m_y[i];
+    }
+
+    // keep the cell count in line with the population, a sparse tank just gets bigger cells
+    m_cellSize = std::max(cellSize, 1.0f);
+    long maxCells = 4L * count + 64;
+    while (true){
+        m_cols = int((maxX - minX) / m_cellSize) + 1;
+        m_rows = int((maxY - minY) / m_cellSize) + 1;
+        if (long(m_cols) * m_rows <= maxCells) break;
+        m_cellSize *= 2;
+    }
+    m_originX = minX;
+    m_originY = minY;
+
+    int cells = m_cols * m_rows;
+    m_cellStart.assign(cells + 1, 0);
+    for (int i = 0; i < count; ++i){
+        m_cellOf[i] = cellY(m_y[i]) * m_cols + cellX(m_x[i]);
+        ++m_cellStart[m_cellOf[i] + 1];
+    }
+    for (int c = 0; c < cells; ++c){
+        m_cellStart[c + 1] += m_cellStart[c];
+    }
+    m_items.resize(count);
+    m_fill.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+    for (int i = 0; i < count; ++i){
+        m_items[m_fill[m_cellOf[i]]++] = i;
+    }
+}
+
+void SpatialGrid::QueryRadius(float x, float y, float radius, std::vector<int>& out) const {
+    out.clear();
+    if (m_x.empty()) return;
+    // creatures are binned by their center, so reach out by the biggest radius too
+    float reach = radius + m_maxRadius;
+    int x0 = cellX(x - reach), x1 = cellX(x + reach);
+    int y0 = cellY(y - reach), y1 = cellY(y + reach);
+    for (int cy = y0; cy <= y1; ++cy){
+        for (int cx = x0; cx <= x1; ++cx){
+            int cell = cy * m_cols + cx;
+            for (int k = m_cellStart[cell]; k < m_cellStart[cell + 1]; ++k){
+                int i = m_items[k];
+                float dx = m_x[i] - x;
+                float dy = m_y[i] - y;
+                float r = radius + m_r[i];
+                if (dx * dx + dy * dy < r * r){
+                    out.push_back(i);
+                }
+            }
+        }
+    }
+    std::sort(out.begin(), out.end());
+}
+
+bool SpatialGrid::Overlaps(float x, float y, float radius) const {
+    if (m_x.empty()) return false;
+    float reach = radius + m_maxRadius;
+    int x0 = cellX(x - reach), x1 = cellX(x + reach);
+    int y0 = cellY(y - reach), y1 = cellY(y + reach);
+    for (int cy = y0; cy <= y1; ++cy){
+        for (int cx = x0; cx <= x1; ++cx){
+            int cell = cy * m_cols + cx;
+            for (int k = m_cellStart[cell]; k < m_cellStart[cell + 1]; ++k){
+                int i = m_items[k];
+                float dx = m_x[i] - x;
+                float dy = m_y[i] - y;
+                float r = radius + m_r[i];
+                if (dx * dx + dy * dy < r * r) return true;
+            }
+        }
+    }
+    return false;
+}
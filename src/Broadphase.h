@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include "Core.h"
+
+
+enum class BroadphaseKind {
+    BRUTE_FORCE,
+    SWEEP_AND_PRUNE
+};
+
+string BroadphaseKindToString(BroadphaseKind k);
+
+// visitor gets the indices of a candidate pair, returning true stops the search
+using BroadphasePairVisitor = std::function<bool(int, int)>;
+
+// a broadphase only narrows down which pairs are worth a real collision test,
+// the swept test itself still runs on every candidate it hands out
+class Broadphase {
+    public:
+        virtual ~Broadphase() = default;
+        virtual BroadphaseKind GetKind() const = 0;
+        virtual void ForEachCandidatePair(const std::vector<std::shared_ptr<Creature>>& creatures, const BroadphasePairVisitor& visit) = 0;
+};
+
+std::unique_ptr<Broadphase> MakeBroadphase(BroadphaseKind kind);
+
+
+class BruteForceBroadphase : public Broadphase {
+    public:
+        BroadphaseKind GetKind() const override { return BroadphaseKind::BRUTE_FORCE; }
+        void ForEachCandidatePair(const std::vector<std::shared_ptr<Creature>>& creatures, const BroadphasePairVisitor& visit) override;
+};
+
+// sort and sweep along x
+// the interval list is kept between calls and fixed up with an insertion sort, fish only move
+// a few pixels per tick so the order barely changes and the sort is close to linear
+class SweepAndPruneBroadphase : public Broadphase {
+    public:
+        BroadphaseKind GetKind() const override { return BroadphaseKind::SWEEP_AND_PRUNE; }
+        void ForEachCandidatePair(const std::vector<std::shared_ptr<Creature>>& creatures, const BroadphasePairVisitor& visit) override;
+        int GetLastSwapCount() const { return m_lastSwaps; }
+    private:
+        struct SweepEntry {
+            const Creature* creature;
+            int index;
+            float minX, maxX;
+            float minY, maxY;
+        };
+        void sync(const std::vector<std::shared_ptr<Creature>>& creatures);
+        static void fitBounds(SweepEntry& e, const Creature& c);
+
+        std::vector<SweepEntry> m_entries;
+        std::unordered_map<const Creature*, int> m_lookup;
+        std::vector<char> m_seen;
+        int m_lastSwaps = 0;
+};
+
+
+// uniform grid over the creatures, rebuilt in one counting sort pass
+// cells store creature indices grouped together so a query only touches the cells around it
+// and the creatures inside them, the bounds follow the creatures so the grid never outgrows them
+class SpatialGrid {
+    public:
+        void Build(const std::vector<std::shared_ptr<Creature>>& creatures, float cellSize);
+        // indices of creatures whose collision circle touches the query circle, in index order
+        void QueryRadius(float x, float y, float radius, std::vector<int>& out) const;
+        // true as soon as any creature's collision circle touches the query circle
+        bool Overlaps(float x, float y, float radius) const;
+        // calls fn(index, dx, dy, distSq) for every creature whose center is within radius of (x, y)
+        template<class Fn>
+        void ForEachCenterWithin(float x, float y, float radius, Fn&& fn) const {
+            if (m_x.empty()) return;
+            int x0 = cellX(x - radius), x1 = cellX(x + radius);
+            int y0 = cellY(y - radius), y1 = cellY(y + radius);
+            float r2 = radius * radius;
+            for (int cy = y0; cy <= y1; ++cy){
+                for (int cx = x0; cx <= x1; ++cx){
+                    int cell = cy * m_cols + cx;
+                    for (int k = m_cellStart[cell]; k < m_cellStart[cell + 1]; ++k){
+                        int i = m_items[k];
+                        float dx = m_x[i] - x;
+                        float dy = m_y[i] - y;
+                        float d2 = dx * dx + dy * dy;
+                        if (d2 < r2) fn(i, dx, dy, d2);
+                    }
+                }
+            }
+        }
+        // the k creatures with the closest centers within maxRadius that accept(index) allows,
+        // nearest first, written to outIndex / outDistSq (both hold k), returns how many were found
+        // cells are searched in rings around (x, y), stopping once no further ring can beat the kth
+        template<class Accept>
+        int KNearest(float x, float y, float maxRadius, int k, Accept&& accept, int* outIndex, float* outDistSq) const {
+            if (m_x.empty() || k <= 0) return 0;
+            int found = 0;
+            float limit = maxRadius * maxRadius;
+            int cx0 = int(std::floor((x - m_originX) / m_cellSize));
+            int cy0 = int(std::floor((y - m_originY) / m_cellSize));
+            int rings = int(maxRadius / m_cellSize) + 1;
+            for (int ring = 0; ring <= rings; ++ring){
+                // everything in this ring is at least ring - 1 cells away
+                float nearest = std::max(0, ring - 1) * m_cellSize;
+                float bound = found == k ? outDistSq[k - 1] : limit;
+                if (nearest * nearest >= bound) break;
+                for (int cy = cy0 - ring; cy <= cy0 + ring; ++cy){
+                    if (cy < 0 || cy >= m_rows) continue;
+                    bool edgeRow = cy == cy0 - ring || cy == cy0 + ring;
+                    // inner rows only have the two cells at the ends of the ring
+                    int step = edgeRow ? 1 : std::max(1, 2 * ring);
+                    for (int cx = cx0 - ring; cx <= cx0 + ring; cx += step){
+                        if (cx < 0 || cx >= m_cols) continue;
+                        int cell = cy * m_cols + cx;
+                        for (int at = m_cellStart[cell]; at < m_cellStart[cell + 1]; ++at){
+                            int i = m_items[at];
+                            float dx = m_x[i] - x;
+                            float dy = m_y[i] - y;
+                            float d2 = dx * dx + dy * dy;
+                            if (d2 >= limit || (found == k && d2 >= outDistSq[k - 1]) || !accept(i)) continue;
+                            // insertion into the short sorted list
+                            int slot = found < k ? found++ : k - 1;
+                            while (slot > 0 && outDistSq[slot - 1] > d2){
+                                outIndex[slot] = outIndex[slot - 1];
+                                outDistSq[slot] = outDistSq[slot - 1];
+                                --slot;
+                            }
+                            outIndex[slot] = i;
+                            outDistSq[slot] = d2;
+                        }
+                    }
+                }
+            }
+            return found;
+        }
+        int GetCount() const { return m_x.size(); }
+        float GetCellSize() const { return m_cellSize; }
+        float GetMaxRadius() const { return m_maxRadius; }
+        // farthest any creature's path since its collision checkpoint reaches from where it is now
+        float GetMaxSweep() const { return m_maxSweep; }
+    private:
+        int cellX(float x) const;
+        int cellY(float y) const;
+
+        float m_cellSize = 1;
+        float m_originX = 0;
+        float m_originY = 0;
+        int m_cols = 0;
+        int m_rows = 0;
+        float m_maxRadius = 0;
+        float m_maxSweep = 0;
+        std::vector<int> m_cellStart; // m_cols * m_rows + 1 offsets into m_items
+        std::vector<int> m_items;
+        std::vector<float> m_x;
+        std::vector<float> m_y;
+        std::vector<float> m_r;
+        std::vector<int> m_cellOf;
+        std::vector<int> m_fill;
+};
@@ -0,0 +1,126 @@
+#include "ContactSolver.h"
+
+
+namespace {
+
+// fish bounce off each other as fully as the old reflection did
+const float kRestitution = 1.0f;
+// overlap below this is left alone so resting contacts do not shake
+const float kPenetrationSlop = 0.5f;
+// share of the remaining overlap removed per iteration, under 1 so piles do not overshoot
+const float kCorrectionRate = 0.8f;
+
+}
+
+
+void ContactSolver::Clear(){
+    m_contactA.clear();
+    m_contactB.clear();
+}
+
+void ContactSolver::AddContact(int a, int b){
+    m_contactA.push_back(a);
+    m_contactB.push_back(b);
+}
+
+int ContactSolver::bodyFor(const Creature& c, int index){
+    if(m_bodyOf[index] >= 0) return m_bodyOf[index];
+    int body = m_owner.size();
+    m_bodyOf[index] = body;
+    m_owner.push_back(index);
+    KinematicState s = c.getKinematicState();
+    m_x.push_back(s.x);
+    m_y.push_back(s.y);
+    m_vx.push_back(s.dx * s.speed);
+    m_vy.push_back(s.dy * s.speed);
+    float r = c.getCollisionRadius();
+    m_r.push_back(r);
+    // mass goes with the area of the circle, a radius of zero is treated as immovable
+    m_invMass.push_back(r > 0 ? 1.0f / (r * r) : 0.0f);
+    return body;
+}
+
+void ContactSolver::Solve(const std::vector<std::shared_ptr<Creature>>& creatures, int iterations, const WorldBounds& world){
+    m_residual = 0;
+    if(m_contactA.empty()) return;
+
+    m_bodyOf.assign(creatures.size(), -1);
+    m_owner.clear();
+    m_x.clear(); m_y.clear(); m_vx.clear(); m_vy.clear(); m_r.clear(); m_invMass.clear();
+    int contacts = m_contactA.size();
+    m_slotA.resize(contacts);
+    m_slotB.resize(contacts);
+    for(int k = 0; k < contacts; ++k){
+        m_slotA[k] = bodyFor(*creatures[m_contactA[k]], m_contactA[k]);
+        m_slotB[k] = bodyFor(*creatures[m_contactB[k]], m_contactB[k]);
+    }
+
+    for(int pass = 0; pass < std::max(1, iterations); ++pass){
+        for(int k = 0; k < contacts; ++k){
+            int a = m_slotA[k], b = m_slotB[k];
+            float invSum = m_invMass[a] + m_invMass[b];
+            if(invSum <= 0) continue;
+            float nx = m_x[a] - m_x[b];
+            float ny = m_y[a] - m_y[b];
+            float dist = std::sqrt(nx * nx + ny * ny);
+            if(dist > 0){
+                nx /= dist;
+                ny /= dist;
+            } else {
+                nx = 1; // stacked exactly, any axis separates them
+                ny = 0;
+            }
+
+            // only pairs still closing get an impulse, so later passes do not undo earlier ones
+            // a swept contact that no longer overlaps still gets here and is turned around
+            float closing = (m_vx[a] - m_vx[b]) * nx + (m_vy[a] - m_vy[b]) * ny;
+            if(closing < 0){
+                float j = -(1 + kRestitution) * closing / invSum;
+                m_vx[a] += j * m_invMass[a] * nx;
+                m_vy[a] += j * m_invMass[a] * ny;
+                m_vx[b] -= j * m_invMass[b] * nx;
+                m_vy[b] -= j * m_invMass[b] * ny;
+            }
+
+            float penetration = m_r[a] + m_r[b] - dist;
+            if(penetration > kPenetrationSlop){
+                float push = (penetration - kPenetrationSlop) * kCorrectionRate / invSum;
+                m_x[a] += push * m_invMass[a] * nx;
+                m_y[a] += push * m_invMass[a] * ny;
+                m_x[b] -= push * m_invMass[b] * nx;
+                m_y[b] -= push * m_invMass[b] * ny;
+            }
+        }
+    }
+
+    for(int k = 0; k < contacts; ++k){
+        int a = m_slotA[k], b = m_slotB[k];
+        float dx = m_x[a] - m_x[b];
+        float dy = m_y[a] - m_y[b];
+        m_residual = std::max(m_residual, m_r[a] + m_r[b] - std::sqrt(dx * dx + dy * dy));
+    }
+
+    // speed is a trait of the fish, the exchange only turns it, a light fish hitting a heavy one
+    // turns a lot and the heavy one hardly at all
+    for(size_t body = 0; body < m_owner.size(); ++body){
+        Creature& c = *creatures[m_owner[body]];
+        KinematicState s = c.getKinematicState();
+        s.x = m_x[body];
+        s.y = m_y[body];
+        if(c.getKinematicsKind() == KinematicsKind::DART){
+            // darters keep the vertical heading they came in with, a contact only flips them along x
+            // (a zero dx darts right at full speed, see DartKinematics)
+            if(m_vx[body] != 0){
+                s.dx = std::copysign(s.dx == 0 ? 1.0f : std::fabs(s.dx), m_vx[body]);
+            }
+        } else {
+            float len = std::sqrt(m_vx[body] * m_vx[body] + m_vy[body] * m_vy[body]);
+            if(len > 0){
+                s.dx = m_vx[body] / len;
+                s.dy = m_vy[body] / len;
+            }
+        }
+        c.setKinematicState(s);
+        c.bounce(world);
+    }
+}
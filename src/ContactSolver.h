@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Core.h"
+
+
+// resolves every creature contact of a tick together instead of one pair at a time
+// contacts are visited over a fixed number of iterations, each visit exchanges an impulse
+// along the contact normal weighted by the creatures' masses (area of the collision circle)
+// and pushes overlapping circles apart, so a pile of fish settles over a few passes
+// instead of one bounce shoving a fish into its next neighbor
+class ContactSolver {
+    public:
+        void Clear();
+        // indices into the creature list handed to Solve
+        void AddContact(int a, int b);
+        int GetContactCount() const { return m_contactA.size(); }
+
+        // writes back positions and headings, walls are applied once at the end
+        void Solve(const std::vector<std::shared_ptr<Creature>>& creatures, int iterations, const WorldBounds& world);
+
+        // deepest overlap left after the last solve, in pixels
+        float GetResidualPenetration() const { return m_residual; }
+
+    private:
+        int bodyFor(const Creature& c, int index);
+
+        std::vector<int> m_contactA;
+        std::vector<int> m_contactB;
+
+        // only the creatures that touch something get a body, in the order they were first seen
+        std::vector<int> m_bodyOf; // creature index -> body, -1 when it has none
+        std::vector<int> m_owner;  // body -> creature index
+        std::vector<float> m_x, m_y, m_vx, m_vy, m_r, m_invMass;
+        std::vector<int> m_slotA, m_slotB;
+        float m_residual = 0;
+};
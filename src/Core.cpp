@@ -1,8 +1,46 @@
 #include "Core.h"
 
 
+namespace {
+std::minstd_rand& CreatureRandomEngine(){
+    thread_local std::minstd_rand engine(std::random_device{}());
+    return engine;
+}
+}
+
+int CreatureRandom(){
+    return std::uniform_int_distribution<int>(0, RAND_MAX)(CreatureRandomEngine());
+}
+
+void SeedCreatureRandom(unsigned seed){
+    CreatureRandomEngine().seed(seed);
+}
+
+uint32_t NextCreatureId(){
+    thread_local uint32_t next = 0;
+    return ++next;
+}
+
+
+void CachedLayer::draw(int width, int height) {
+    if (!m_fbo.isAllocated() || m_fbo.getWidth() != width || m_fbo.getHeight() != height) {
+        m_fbo.allocate(width, height, GL_RGBA);
+        m_dirty = true;
+    }
+    if (m_dirty) {
+        m_fbo.begin();
+        ofClear(0, 0, 0, 0);
+        ofSetColor(ofColor::white);
+        m_paint(width, height);
+        m_fbo.end();
+        m_dirty = false;
+    }
+    ofSetColor(ofColor::white);
+    m_fbo.draw(0, 0);
+}
+
+
 // Creature Inherited Base Behavior
-void Creature::setBounds(int w, int h) { m_width = w; m_height = h; }
 void Creature::normalize() {
     float length = std::sqrt(m_dx * m_dx + m_dy * m_dy);
     if (length != 0) {
@@ -11,14 +49,57 @@ void Creature::normalize() {
     }
 }
 
-void Creature::bounce(std::shared_ptr<Creature> other) {
+void Creature::extrapolate(float fromX, float fromY, int ticks, const WorldBounds& world) {
+    m_x += (m_x - fromX) * ticks;
+    m_y += (m_y - fromY) * ticks;
+    // the pattern keeps its pace too, so the creature is in step again when it is back at full rate
+    m_phase = MotionTables::Get(m_motionPattern).advance(m_phase, ticks);
+    bounce(world); // walls still apply to the skipped ticks
+}
+
+void Creature::recordSweepStep() {
+    // a full path keeps stretching its last step to wherever the creature is now
+    int last = m_pathSteps;
+    if (m_pathSteps < kSweepPathSteps) {
+        ++m_pathSteps;
+    } else {
+        --last;
+        float sx = m_pathX[m_pathSteps] - m_pathX[last];
+        float sy = m_pathY[m_pathSteps] - m_pathY[last];
+        m_pathLength -= std::sqrt(sx * sx + sy * sy);
+    }
+    m_pathX[m_pathSteps] = m_x;
+    m_pathY[m_pathSteps] = m_y;
+    float sx = m_x - m_pathX[last];
+    float sy = m_y - m_pathY[last];
+    m_pathLength += std::sqrt(sx * sx + sy * sy);
+}
+
+void Creature::getSweepPoint(int step, float& x, float& y) const {
+    if (step >= getSweepSteps()) {
+        x = m_x;
+        y = m_y;
+    } else {
+        x = m_pathX[step];
+        y = m_pathY[step];
+    }
+}
+
+float Creature::getSweepReach() const {
+    // the path's length bounds it, plus anything that moved the creature after its last step
+    float sx = m_x - m_pathX[m_pathSteps];
+    float sy = m_y - m_pathY[m_pathSteps];
+    return m_pathLength + std::sqrt(sx * sx + sy * sy);
+}
+
+void Creature::bounce(const WorldBounds& world, std::shared_ptr<Creature> other) {
     //bounce off walls
     if(m_x - m_collisionRadius < 0){
         m_x = m_collisionRadius;
         m_dx *= -1;
         setFlipped(!m_flipped);
-    } else if(m_x + m_collisionRadius > m_width){
-        m_x = m_width - m_collisionRadius;
+    } else if(m_x + m_collisionRadius > world.right()){
+        m_x = world.right() - m_collisionRadius;
         m_dx *= -1;
         setFlipped(!m_flipped);
     }
@@ -26,8 +107,8 @@ void Creature::bounce(std::shared_ptr<Creature> other) {
     if(m_y - m_collisionRadius < 0){
         m_y = m_collisionRadius;
         m_dy *= -1;;
-    } else if(m_y + m_collisionRadius > m_height){
-        m_y = m_height - m_collisionRadius;
+    } else if(m_y + m_collisionRadius > world.bottom()){
+        m_y = world.bottom() - m_collisionRadius;
         m_dy *= -1;
     }
 
@@ -89,6 +170,7 @@ void GameEvent::print() const {
                 break;
             case GameEventType::NEW_LEVEL:
                 ofLogVerbose() << "New Game level" << std::endl;
+                break;
             default:
                 ofLogVerbose() << "Unknown event type." << std::endl;
                 break;
@@ -104,6 +186,51 @@ bool checkCollision(std::shared_ptr<Creature> a, std::shared_ptr<Creature> b) {
     return distance < collisionDistance;
 };
 
+namespace {
+// one step of a sweep, both move linearly over it, so in the frame of b the gap is
+// d(t) = d0 + v*t for t in [0, 1] and we look for the first t where |d(t)| < r
+bool checkSweptStep(float a0x, float a0y, float a1x, float a1y,
+                    float b0x, float b0y, float b1x, float b1y, float r) {
+    float d0x = a0x - b0x;
+    float d0y = a0y - b0y;
+    float c = d0x * d0x + d0y * d0y - r * r;
+    if (c < 0) return true; // already touching at the start of the step
+
+    float vx = (a1x - a0x) - (b1x - b0x);
+    float vy = (a1y - a0y) - (b1y - b0y);
+    float qa = vx * vx + vy * vy;
+    float qb = 2.0f * (d0x * vx + d0y * vy);
+    if (qa == 0 || qb >= 0) return false; // not moving closer to each other
+
+    float disc = qb * qb - 4.0f * qa * c;
+    if (disc < 0) return false; // closest approach is still too far
+    float t = (-qb - std::sqrt(disc)) / (2.0f * qa);
+    return t <= 1.0f;
+}
+}
+
+// swept collision between two creatures since their checkpoints
+// the paths are walked a tick at a time side by side, so bounces, zig-zags and turns in between
+// count as they happened; both end now, a creature that joined later just has a shorter path
+bool checkSweptCollision(std::shared_ptr<Creature> a, std::shared_ptr<Creature> b) {
+    float r = a->getCollisionRadius() + b->getCollisionRadius();
+    int stepsA = a->getSweepSteps();
+    int stepsB = b->getSweepSteps();
+    int steps = std::min(stepsA, stepsB);
+    float a0x, a0y, b0x, b0y;
+    a->getSweepPoint(stepsA - steps, a0x, a0y);
+    b->getSweepPoint(stepsB - steps, b0x, b0y);
+    for (int k = 1; k <= steps; ++k) {
+        float a1x, a1y, b1x, b1y;
+        a->getSweepPoint(stepsA - steps + k, a1x, a1y);
+        b->getSweepPoint(stepsB - steps + k, b1x, b1y);
+        if (checkSweptStep(a0x, a0y, a1x, a1y, b0x, b0y, b1x, b1y, r)) return true;
+        a0x = a1x; a0y = a1y;
+        b0x = b1x; b0y = b1y;
+    }
+    return false;
+};
+
 
 string GameSceneKindToString(GameSceneKind t){
     switch(t)
@@ -111,7 +238,9 @@ string GameSceneKindToString(GameSceneKind t){
         case GameSceneKind::GAME_INTRO: return "GAME_INTRO";
         case GameSceneKind::AQUARIUM_GAME: return "AQUARIUM_GAME";
         case GameSceneKind::GAME_OVER: return "GAME_OVER";
+        case GameSceneKind::REMOTE_VIEW: return "REMOTE_VIEW";
     };
+    return "UNKNOWN_SCENE";
 };
 
 std::shared_ptr<GameScene> GameSceneManager::GetScene(string name){
@@ -164,21 +293,42 @@ void GameSceneManager::DrawActiveScene(){
     this->m_active_scene->Draw();
 }
 
+bool GameSceneManager::IsActiveSceneOpaque(){
+    if(this->m_active_scene == nullptr){return false;}
+    return this->m_active_scene->IsOpaque();
+}
+
+void GameSceneManager::InvalidateScenes(){
+    for(std::shared_ptr<GameScene> scene : this->m_scenes){
+        scene->Invalidate();
+    }
+}
+
+
+GameIntroScene::GameIntroScene(string name, std::shared_ptr<GameSprite> banner)
+: m_name(name), m_banner(std::move(banner)), m_layer([this](int, int){
+    this->m_banner->draw(0,0);
+}){}
 
 void GameIntroScene::Update(){
 
 }
 
 void GameIntroScene::Draw(){
-    this->m_banner->draw(0,0);
+    this->m_layer.draw(ofGetWindowWidth(), ofGetWindowHeight());
 }
 
+GameOverScene::GameOverScene(string name, std::shared_ptr<GameSprite> banner)
+: m_name(name), m_banner(std::move(banner)), m_layer([this](int, int){
+    ofBackgroundGradient(ofColor::red, ofColor::black);
+    this->m_banner->draw(0,0);
+}){}
+
 void GameOverScene::Update(){
 
 }
 
 void GameOverScene::Draw(){
-    ofBackgroundGradient(ofColor::red, ofColor::black);
-    this->m_banner->draw(0,0);
+    this->m_layer.draw(ofGetWindowWidth(), ofGetWindowHeight());
 
 }
\ No newline at end of file
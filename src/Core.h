@@ -1,10 +1,24 @@
+#pragma once
+
 #include <iostream>
 #include <memory>
 #include <utility>
 #include <cmath>
 #include <algorithm>
+#include <random>
+#include <functional>
+#include <cstdint>
 #include "ofMain.h"
+#include "MemoryAccounting.h"
+#include "MotionTables.h"
+
 
+// drop in for rand() with one generator per thread, so headless sessions running side by side
+// neither share nor fight over the global state and replay the same way from the same seed
+int CreatureRandom();
+void SeedCreatureRandom(unsigned seed);
+// never 0, unique within a thread the way the random stream is per thread, so parallel sessions each count their own
+uint32_t NextCreatureId();
 
 class AwaitFrames {
 public:
@@ -22,6 +36,78 @@ private:
 	int m_counter;
 };
 
+// the walls of the tank, one of these is shared by everything that swims in it
+// creatures bounce off the right and bottom walls inset from the edge of the world
+struct WorldBounds {
+    float width = 0;
+    float height = 0;
+    float inset = 0;
+    float right() const { return width - inset; }
+    float bottom() const { return height - inset; }
+};
+
+// view into a world that can be bigger than the window, the world has its own units
+// and zoom maps them to pixels, so the window size only changes how much of it is seen
+// the view never leaves the world, a world smaller than the view just pins it at the origin
+class GameCamera {
+public:
+    // screen size in pixels, zoom in pixels per world unit
+    void setViewport(float screenW, float screenH, float zoom = 1) {
+        m_zoom = zoom;
+        m_viewW = screenW / zoom;
+        m_viewH = screenH / zoom;
+    }
+    void setWorld(float w, float h) { m_worldW = w; m_worldH = h; }
+    void follow(float x, float y) {
+        m_x = std::min(std::max(x - m_viewW / 2, 0.0f), std::max(m_worldW - m_viewW, 0.0f));
+        m_y = std::min(std::max(y - m_viewH / 2, 0.0f), std::max(m_worldH - m_viewH, 0.0f));
+    }
+    // margin grows the view on every side, sprites are drawn from their top left corner so they need one
+    bool isVisible(float x, float y, float margin) const {
+        return x >= m_x - margin && x <= m_x + m_viewW + margin
+            && y >= m_y - margin && y <= m_y + m_viewH + margin;
+    }
+    float getX() const { return m_x; }
+    float getY() const { return m_y; }
+    float getViewWidth() const { return m_viewW; }
+    float getViewHeight() const { return m_viewH; }
+    float getZoom() const { return m_zoom; }
+    float toScreenX(float worldX) const { return (worldX - m_x) * m_zoom; }
+    float toScreenY(float worldY) const { return (worldY - m_y) * m_zoom; }
+
+    // everything drawn between begin and end is in world coordinates
+    void begin() const {
+        ofPushMatrix();
+        ofScale(m_zoom, m_zoom);
+        ofTranslate(-m_x, -m_y);
+    }
+    void end() const { ofPopMatrix(); }
+
+private:
+    float m_x = 0;
+    float m_y = 0;
+    float m_viewW = 0;
+    float m_viewH = 0;
+    float m_zoom = 1;
+    float m_worldW = 0;
+    float m_worldH = 0;
+};
+
+// a layer that only changes when told to (or when the window size changes)
+// it is painted once into an offscreen buffer and after that every frame is a single blit
+class CachedLayer {
+public:
+    explicit CachedLayer(std::function<void(int, int)> paint) : m_paint(std::move(paint)) {}
+    void draw(int width, int height);
+    void invalidate() { m_dirty = true; }
+    bool isDirty() const { return m_dirty; }
+
+private:
+    std::function<void(int, int)> m_paint;
+    ofFbo m_fbo;
+    bool m_dirty = true;
+};
+
 class GameSprite {
 public:
     GameSprite(const std::string& imagePath, int width, int height) {
@@ -29,28 +115,72 @@ public:
             std::cerr << "Failed to load image: " << imagePath << std::endl;
         }
         m_image.resize(width, height);
-        m_flippedImage = m_image;
-        m_flippedImage.mirror(false, true); // Mirror horizontally
+        m_trackedBytes = estimateBytes();
+        MemoryLedger::Allocated(MemorySubsystem::SPRITES, m_trackedBytes);
     }
-
-    void draw(float x, float y) const {
-        if (m_flipped) {
-            m_flippedImage.draw(x, y);
+    // every copy owns its own pixels and texture, so it is booked again
+    GameSprite(const GameSprite& other)
+    : m_image(other.m_image), m_trackedBytes(other.m_trackedBytes) {
+        MemoryLedger::Allocated(MemorySubsystem::SPRITES, m_trackedBytes);
+    }
+    GameSprite& operator=(const GameSprite& other) {
+        m_image = other.m_image;
+        MemoryLedger::Freed(MemorySubsystem::SPRITES, m_trackedBytes);
+        m_trackedBytes = other.m_trackedBytes;
+        MemoryLedger::Allocated(MemorySubsystem::SPRITES, m_trackedBytes);
+        return *this;
+    }
+    ~GameSprite() { MemoryLedger::Freed(MemorySubsystem::SPRITES, m_trackedBytes); }
+
+    // sprites are shared, so which way one faces is up to whoever draws it
+    // scale grows it away from (x, y)
+    void draw(float x, float y, bool flipped = false, float scale = 1) const {
+        float w = m_image.getWidth() * scale;
+        float h = m_image.getHeight() * scale;
+        if (flipped) {
+            m_image.draw(x + w, y, -w, h);
         } else {
-            m_image.draw(x, y);
+            m_image.draw(x, y, w, h);
         }
     }
 
-    void setFlipped(bool flipped) { m_flipped = flipped; }
+    const ofImage& getImage() const { return m_image; }
 
 private:
+    // the pixels stay on the CPU and a texture of the same size lives on the GPU
+    int64_t estimateBytes() const { return 2 * int64_t(m_image.getPixels().size()); }
+
     ofImage m_image;
-    ofImage m_flippedImage;
-    bool m_flipped = false;
+    int64_t m_trackedBytes = 0;
 };
 
 
 
+// which batched motion a creature uses, CUSTOM ones only move through their virtual move()
+enum class KinematicsKind : uint8_t {
+    CUSTOM,
+    SWIM,
+    CRUISE,
+    DRIFT,
+    DART
+};
+const int kKinematicsKindCount = 5;
+
+// the swept collision test follows a creature one tick at a time for this many ticks after its
+// checkpoint, a longer wait between checks runs the newest ticks together into one straight step
+const int kSweepPathSteps = 10;
+
+// the part of a creature its kinematics read and write, see CreatureKinematics.h
+struct KinematicState {
+    float x;
+    float y;
+    float dx;
+    float dy;
+    float speed;
+    float phase;   // position in the motion pattern, in MotionTable entries
+    uint8_t pattern; // MotionTables id, only the kinds that follow a pattern look at it
+};
+
 class Creature {
 protected:
     Creature(float x, float y, int speed, float collisionRadius, int value, bool flipped,
@@ -60,28 +190,40 @@ protected:
     , m_dx(0)
     , m_dy(0)
     , m_speed(speed)
-    , m_width(0)
-    , m_height(0)
     , m_collisionRadius(collisionRadius)
     , m_value(value)
     , m_flipped(flipped)
-    , m_sprite(std::move(sprite)) {}
+    , m_sprite(std::move(sprite))
+    , m_id(NextCreatureId()) { markCollisionCheckpoint(); }
 
     float m_x = 0.0f;
     float m_y = 0.0f;
     float m_dx = 0.0f;
     float m_dy = 0.0f;
+    // where the creature was at the last collision check and after every tick since,
+    // the sweep follows these instead of cutting straight across bounces and turns
+    float m_pathX[kSweepPathSteps + 1] = {};
+    float m_pathY[kSweepPathSteps + 1] = {};
+    float m_pathLength = 0.0f;
+    uint8_t m_pathSteps = 0;
     int m_speed = 0;
-    float m_width = 0.0f;
-    float m_height = 0.0f;
     float m_collisionRadius = 0.0f;
     int m_value = 0;
     bool m_flipped = false;
+    float m_phase = 0.0f; // where the creature is in its motion pattern, if it has one
+    uint8_t m_motionPattern = 0;
+    // where the creature is in its sprite's animation, the frames themselves are shared
+    uint8_t m_animFrame = 0;
+    uint8_t m_animTimer = 0;
+    KinematicsKind m_kinematics = KinematicsKind::CUSTOM;
+    int m_kinematicSlot = -1; // where it sits in its aquarium's KinematicBatch, -1 outside one
     std::shared_ptr<GameSprite> m_sprite;
+    uint32_t m_id; // how snapshots refer to the creature, a creature streamed back in gets a new one
 
 public:
     virtual ~Creature() = default;
-    virtual void move() = 0;
+    // one tick of motion, ending with a bounce off the walls
+    virtual void move(const WorldBounds& world) = 0;
     virtual void draw() const = 0;
 
     virtual float getCollisionRadius() const { return m_collisionRadius; }
@@ -89,19 +231,51 @@ public:
 
     float getX() const { return m_x; }
     float getY() const { return m_y; }
+    uint32_t getId() const { return m_id; }
+    KinematicsKind getKinematicsKind() const { return m_kinematics; }
+    KinematicState getKinematicState() const { return KinematicState{m_x, m_y, m_dx, m_dy, float(m_speed), m_phase, m_motionPattern}; }
+    // speed and pattern stay with the creature, everything else is taken from the state
+    void setKinematicState(const KinematicState& s) { m_x = s.x; m_y = s.y; m_dx = s.dx; m_dy = s.dy; m_phase = s.phase; }
+    int getKinematicSlot() const { return m_kinematicSlot; }
+    void setKinematicSlot(int slot) { m_kinematicSlot = slot; }
+    // taken by the aquarium's batch when the creature joins the tank, set it before adding
+    int getMotionPattern() const { return m_motionPattern; }
+    void setMotionPattern(int id) { if (id >= 0 && id < MotionTables::GetCount()) m_motionPattern = uint8_t(id); }
+    float getDx() const { return m_dx; }
+    float getDy() const { return m_dy; }
+    void setVelocity(float dx, float dy) { m_dx = dx; m_dy = dy; }
+    float getPrevX() const { return m_pathX[0]; }
+    float getPrevY() const { return m_pathY[0]; }
+    void markCollisionCheckpoint() { m_pathX[0] = m_x; m_pathY[0] = m_y; m_pathSteps = 0; m_pathLength = 0; }
+    // once a tick after moving, whatever moved it
+    void recordSweepStep();
+    // steps in the path, the last one always ends where the creature is now
+    int getSweepSteps() const { return std::max<int>(m_pathSteps, 1); }
+    void getSweepPoint(int step, float& x, float& y) const;
+    // no point of the path is farther than this from where the creature is now
+    float getSweepReach() const;
+    // moves without sweeping, for placing a creature rather than moving it
+    void setPosition(float x, float y) { m_x = x; m_y = y; markCollisionCheckpoint(); }
     int getSpeed() const { return m_speed; }
     void setSpeed(int speed) { m_speed = speed; }
-    void setFlipped(bool flipped) {
-        if (m_sprite) {
-            m_sprite->setFlipped(flipped);
-        }
+    void setFlipped(bool flipped) { m_flipped = flipped; }
+    bool isFlipped() const { return m_flipped; }
+    int getAnimationFrame() const { return m_animFrame; }
+    void setAnimationFrame(int frame) { m_animFrame = uint8_t(frame); m_animTimer = 0; }
+    void advanceAnimation(int frames, int ticksPerFrame) {
+        if (++m_animTimer < ticksPerFrame) return;
+        m_animTimer = 0;
+        if (++m_animFrame >= frames) m_animFrame = 0;
     }
     void setSprite(std::shared_ptr<GameSprite> sprite) { m_sprite = std::move(sprite); }
     int getValue() const { return m_value; }
+    void setValue(int value) { m_value = value; }
 
-    void setBounds(int w, int h);
     void normalize();
-    void bounce(std::shared_ptr<Creature> other);
+    // repeat the last step (from fromX, fromY to here) for extra ticks, used for creatures updated at a lower rate
+    // the motion pattern phase moves on by the same number of ticks
+    void extrapolate(float fromX, float fromY, int ticks, const WorldBounds& world);
+    void bounce(const WorldBounds& world, std::shared_ptr<Creature> other = nullptr);
 };
 
 // GameEvents
@@ -143,6 +317,8 @@ class GameEvent {
 
 
 bool checkCollision(std::shared_ptr<Creature> a, std::shared_ptr<Creature> b);
+// swept circle test over the motion since the last collision checkpoint of both creatures
+bool checkSweptCollision(std::shared_ptr<Creature> a, std::shared_ptr<Creature> b);
 
 
 class GameLevel {
@@ -165,6 +341,10 @@ class GameScene {
         virtual string GetName() = 0;
         virtual void Update() = 0;
         virtual void Draw() = 0;
+        // scenes that cover the whole window let the app skip painting what is under them
+        virtual bool IsOpaque() { return false; }
+        // drop anything cached for the old window size
+        virtual void Invalidate() {}
         virtual ~GameScene() = default;
 
 };
@@ -172,33 +352,38 @@ class GameScene {
 enum class GameSceneKind {
     GAME_INTRO,
     AQUARIUM_GAME,
-    GAME_OVER
+    GAME_OVER,
+    REMOTE_VIEW // drawing a game another process runs
 };
 
 string GameSceneKindToString(GameSceneKind t);
 
 class GameIntroScene : public GameScene {
     public:
-        GameIntroScene(string name, std::shared_ptr<GameSprite> banner)
-        : m_name(name), m_banner(std::move(banner)){};
+        GameIntroScene(string name, std::shared_ptr<GameSprite> banner);
         string GetName() override {return this->m_name;}
         void Update() override;
         void Draw() override;
+        bool IsOpaque() override {return true;}
+        void Invalidate() override {this->m_layer.invalidate();}
     private:
         string m_name;
         std::shared_ptr<GameSprite> m_banner;
+        CachedLayer m_layer; // nothing in the intro moves, it is painted once
 };
 
 class GameOverScene : public GameScene {
     public:
-        GameOverScene(string name, std::shared_ptr<GameSprite> banner)
-        : m_name(name), m_banner(std::move(banner)){};
+        GameOverScene(string name, std::shared_ptr<GameSprite> banner);
         string GetName() override {return this->m_name;}
         void Update() override;
         void Draw() override;
+        bool IsOpaque() override {return true;}
+        void Invalidate() override {this->m_layer.invalidate();}
     private:
         string m_name;
         std::shared_ptr<GameSprite> m_banner;
+        CachedLayer m_layer; // gradient and banner, painted once
 };
 
 
@@ -214,6 +399,8 @@ class GameSceneManager {
         string GetActiveSceneName();
         void UpdateActiveScene();
         void DrawActiveScene();
+        bool IsActiveSceneOpaque();
+        void InvalidateScenes();
 
     private:
         std::vector<std::shared_ptr<GameScene>> m_scenes;
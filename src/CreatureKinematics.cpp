@@ -0,0 +1,35 @@
+#include "CreatureKinematics.h"
+
+
+void KinematicBatch::add(Creature* creature) {
+    creature->setKinematicSlot(m_owners.size());
+    m_owners.push_back(creature);
+    m_phase.push_back(creature->getKinematicState().phase);
+    m_pattern.push_back(uint8_t(creature->getMotionPattern()));
+}
+
+// the last member takes the leaver's slot, so nobody else has to move
+void KinematicBatch::remove(Creature* creature) {
+    int slot = creature->getKinematicSlot();
+    if (slot < 0 || slot >= int(m_owners.size()) || m_owners[slot] != creature) return;
+    int last = m_owners.size() - 1;
+    if (slot != last) {
+        m_owners[slot] = m_owners[last];
+        m_phase[slot] = m_phase[last];
+        m_pattern[slot] = m_pattern[last];
+        m_owners[slot]->setKinematicSlot(slot);
+    }
+    m_owners.pop_back();
+    m_phase.pop_back();
+    m_pattern.pop_back();
+    creature->setKinematicSlot(-1);
+}
+
+void KinematicBatch::clear() {
+    for (Creature* creature : m_owners) {
+        creature->setKinematicSlot(-1);
+    }
+    m_owners.clear();
+    m_phase.clear();
+    m_pattern.clear();
+}
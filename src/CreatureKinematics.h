@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include "Core.h"
+
+
+// compile time motion policies, one per kind of swimmer
+// each one is a plain struct with an inline step over a KinematicState, so a batch of one kind
+// compiles into a single loop with no virtual calls, and the creature classes call the very same
+// step from their move() so both paths always agree
+
+// base fish and powerups, straight line at full speed
+struct SwimKinematics {
+    static const bool kFlips = true;
+    static void step(KinematicState& s) {
+        s.x += s.dx * s.speed;
+        s.y += s.dy * s.speed;
+    }
+    static bool facesLeft(const KinematicState& s) { return s.dx < 0; }
+};
+
+// bigger fish, same as swimming but at half speed
+struct CruiseKinematics {
+    static const bool kFlips = true;
+    static void step(KinematicState& s) {
+        s.x += s.dx * (s.speed * 0.5f);
+        s.y += s.dy * (s.speed * 0.5f);
+    }
+    static bool facesLeft(const KinematicState& s) { return s.dx < 0; }
+};
+
+// jellyfish, slow sideways drift while bobbing up and down (MotionTables::kBob by default)
+struct DriftKinematics {
+    static const bool kFlips = false;
+    static void step(KinematicState& s) {
+        const MotionTable& bob = MotionTables::Get(s.pattern);
+        s.phase = bob.advance(s.phase);
+        s.x += (s.dx == 0 ? 1 : s.dx) * (s.speed * 0.4f);
+        s.y += bob.sample(s.phase);
+    }
+    static bool facesLeft(const KinematicState&) { return false; }
+};
+
+// fast fish, quick sideways dart with a zig-zag on top (MotionTables::kZigZag by default)
+// the sprite faces the other way round so it flips when heading right
+struct DartKinematics {
+    static const bool kFlips = true;
+    static void step(KinematicState& s) {
+        const MotionTable& zig = MotionTables::Get(s.pattern);
+        s.phase = zig.advance(s.phase);
+        s.x += (s.dx == 0 ? 1 : s.dx) * (s.speed * 1.2f);
+        s.y += s.dy * (s.speed * 1.2f) + zig.sample(s.phase);
+    }
+    static bool facesLeft(const KinematicState& s) { return !(s.dx < 0); }
+};
+
+// every creature of one kinematics kind in an aquarium, kept as it joins and leaves the tank
+// the motion phase and pattern live here between ticks (the creature gets a copy after every step
+// for whoever reads it from outside), everything else the rest of the game writes too, so it is
+// gathered fresh each tick into scratch arrays that keep their size
+class KinematicBatch {
+    public:
+        // phase and pattern are taken from the creature as it joins
+        void add(Creature* creature);
+        void remove(Creature* creature);
+        void clear();
+        size_t size() const { return m_owners.size(); }
+
+        // extraTicksFor(creature, slot) is -1 to leave a creature out this tick, otherwise how many
+        // skipped ticks its step stands in for, every member's sweep path gets the tick either way
+        template<class Kinematics, class Schedule>
+        void run(const WorldBounds& world, Schedule extraTicksFor);
+        // the same for creatures with their own move(), no arrays
+        template<class Schedule>
+        void runVirtual(const WorldBounds& world, Schedule extraTicksFor);
+
+    private:
+        // one entry per member, slot order
+        std::vector<Creature*> m_owners;
+        std::vector<float> m_phase;
+        std::vector<uint8_t> m_pattern;
+        // this tick's due members, packed
+        std::vector<int> m_due;
+        std::vector<int> m_extraTicks;
+        std::vector<float> m_x, m_y, m_dx, m_dy, m_speed, m_stepPhase;
+        std::vector<uint8_t> m_stepPattern;
+};
+
+template<class Kinematics, class Schedule>
+void KinematicBatch::run(const WorldBounds& world, Schedule extraTicksFor) {
+    size_t members = m_owners.size();
+    if (m_x.size() < members) {
+        m_due.resize(members);
+        m_extraTicks.resize(members);
+        m_x.resize(members);
+        m_y.resize(members);
+        m_dx.resize(members);
+        m_dy.resize(members);
+        m_speed.resize(members);
+        m_stepPhase.resize(members);
+        m_stepPattern.resize(members);
+    }
+    size_t count = 0;
+    for (size_t slot = 0; slot < members; ++slot) {
+        Creature& c = *m_owners[slot];
+        int extraTicks = extraTicksFor(c, int(slot));
+        // a creature left out this tick stays put, its path still gets the tick
+        if (extraTicks < 0) { c.recordSweepStep(); continue; }
+        KinematicState s = c.getKinematicState();
+        m_due[count] = int(slot);
+        m_extraTicks[count] = extraTicks;
+        m_x[count] = s.x;
+        m_y[count] = s.y;
+        m_dx[count] = s.dx;
+        m_dy[count] = s.dy;
+        m_speed[count] = s.speed;
+        m_stepPhase[count] = m_phase[slot];
+        m_stepPattern[count] = m_pattern[slot];
+        ++count;
+    }
+
+    float* x = m_x.data();
+    float* y = m_y.data();
+    const float* dx = m_dx.data();
+    const float* dy = m_dy.data();
+    const float* speed = m_speed.data();
+    float* phase = m_stepPhase.data();
+    const uint8_t* pattern = m_stepPattern.data();
+    // the hot loop only touches the arrays, the step inlines into it
+    for (size_t i = 0; i < count; ++i) {
+        KinematicState s{x[i], y[i], dx[i], dy[i], speed[i], phase[i], pattern[i]};
+        Kinematics::step(s);
+        x[i] = s.x;
+        y[i] = s.y;
+        phase[i] = s.phase;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        int slot = m_due[i];
+        Creature& c = *m_owners[slot];
+        float fromX = c.getX();
+        float fromY = c.getY();
+        KinematicState s{x[i], y[i], dx[i], dy[i], speed[i], phase[i], pattern[i]};
+        c.setKinematicState(s);
+        if (Kinematics::kFlips) c.setFlipped(Kinematics::facesLeft(s));
+        c.bounce(world);
+        if (m_extraTicks[i] > 0) c.extrapolate(fromX, fromY, m_extraTicks[i], world);
+        m_phase[slot] = c.getKinematicState().phase; // extrapolating moves it on too
+        c.recordSweepStep();
+    }
+}
+
+template<class Schedule>
+void KinematicBatch::runVirtual(const WorldBounds& world, Schedule extraTicksFor) {
+    for (size_t slot = 0; slot < m_owners.size(); ++slot) {
+        Creature& c = *m_owners[slot];
+        int extraTicks = extraTicksFor(c, int(slot));
+        if (extraTicks < 0) { c.recordSweepStep(); continue; }
+        float fromX = c.getX();
+        float fromY = c.getY();
+        c.move(world);
+        if (extraTicks > 0) c.extrapolate(fromX, fromY, extraTicks, world);
+        m_phase[slot] = c.getKinematicState().phase;
+        c.recordSweepStep();
+    }
+}
@@ -0,0 +1,211 @@
+#include "FramePacing.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "ofMain.h"
+
+
+uint64_t FrameClockMicros(){
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+std::string FrameSectionToString(FrameSection s){
+    switch(s){
+        case FrameSection::STREAMING: return "streaming";
+        case FrameSection::COLLISIONS: return "collisions";
+        case FrameSection::SIMULATION: return "simulation";
+        case FrameSection::UPDATE_OTHER: return "update_other";
+        case FrameSection::DRAW: return "draw";
+        case FrameSection::PRESENT: return "present";
+        default: return "unknown";
+    }
+}
+
+
+void FramePacingRecorder::Start(size_t capacity){
+    m_frames.assign(std::max<size_t>(capacity, 2), FrameRecord());
+    m_recorded = 0;
+}
+
+void FramePacingRecorder::BeginUpdate(){
+    if(!this->IsRecording()) return;
+    uint64_t now = FrameClockMicros();
+    if(m_recorded > 0){
+        current().swapUs = now;
+    }
+    ++m_recorded;
+    current() = FrameRecord();
+    current().updateStartUs = now;
+}
+
+void FramePacingRecorder::EndUpdate(const UpdateBreakdown& parts){
+    if(!this->IsRecording() || m_recorded == 0) return;
+    current().updateEndUs = FrameClockMicros();
+    current().update = parts;
+}
+
+void FramePacingRecorder::BeginDraw(){
+    if(!this->IsRecording() || m_recorded == 0) return;
+    current().drawStartUs = FrameClockMicros();
+}
+
+void FramePacingRecorder::EndDraw(){
+    if(!this->IsRecording() || m_recorded == 0) return;
+    current().drawEndUs = FrameClockMicros();
+}
+
+bool FramePacingRecorder::Save(const std::string& path) const {
+    std::ofstream out(path);
+    if(!out){
+        ofLogError() << "could not write frame log " << path << std::endl;
+        return false;
+    }
+    out << "update_start_us,update_end_us,draw_start_us,draw_end_us,swap_us,streaming_us,collisions_us,simulation_us\n";
+    // the frame in progress has no swap yet, everything before it that is still in the buffer does
+    uint64_t complete = m_recorded > 0 ? m_recorded - 1 : 0;
+    uint64_t first = complete > m_frames.size() - 1 ? complete - (m_frames.size() - 1) : 0;
+    for(uint64_t i = first; i < complete; ++i){
+        const FrameRecord& f = m_frames[i % m_frames.size()];
+        out << f.updateStartUs << "," << f.updateEndUs << "," << f.drawStartUs << "," << f.drawEndUs << "," << f.swapUs << ","
+            << f.update.streamingUs << "," << f.update.collisionsUs << "," << f.update.simulationUs << "\n";
+    }
+    ofLogNotice() << "saved " << complete - first << " frame timings to " << path << std::endl;
+    return bool(out);
+}
+
+
+namespace {
+
+const int kSections = int(FrameSection::COUNT);
+
+struct FrameTimes {
+    double intervalMs = 0;
+    std::array<double, kSections> sectionMs = {};
+};
+
+bool ParseFrame(const std::string& line, FrameRecord& f){
+    std::istringstream fields(line);
+    char comma;
+    return bool(fields >> f.updateStartUs >> comma >> f.updateEndUs >> comma >> f.drawStartUs >> comma
+                       >> f.drawEndUs >> comma >> f.swapUs >> comma >> f.update.streamingUs >> comma
+                       >> f.update.collisionsUs >> comma >> f.update.simulationUs);
+}
+
+FrameTimes Split(const FrameRecord& f){
+    FrameTimes t;
+    t.intervalMs = (f.swapUs - f.updateStartUs) / 1000.0;
+    double updateMs = (f.updateEndUs - f.updateStartUs) / 1000.0;
+    t.sectionMs[int(FrameSection::STREAMING)] = f.update.streamingUs / 1000.0;
+    t.sectionMs[int(FrameSection::COLLISIONS)] = f.update.collisionsUs / 1000.0;
+    t.sectionMs[int(FrameSection::SIMULATION)] = f.update.simulationUs / 1000.0;
+    t.sectionMs[int(FrameSection::UPDATE_OTHER)] = std::max(0.0,
+        updateMs - (f.update.streamingUs + f.update.collisionsUs + f.update.simulationUs) / 1000.0);
+    // frames that skipped draw (a window being dragged) count all of it as present
+    double drawMs = f.drawEndUs >= f.drawStartUs && f.drawStartUs >= f.updateEndUs ? (f.drawEndUs - f.drawStartUs) / 1000.0 : 0;
+    t.sectionMs[int(FrameSection::DRAW)] = drawMs;
+    t.sectionMs[int(FrameSection::PRESENT)] = std::max(0.0, t.intervalMs - updateMs - drawMs);
+    return t;
+}
+
+double Percentile(std::vector<double> values, double p){
+    if(values.empty()) return 0;
+    size_t at = std::min(values.size() - 1, size_t(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + at, values.end());
+    return values[at];
+}
+
+}
+
+
+int AnalyzeFrameLog(const std::string& path, float targetFps){
+    std::ifstream in(path);
+    if(!in){
+        ofLogError() << "could not read frame log " << path << std::endl;
+        return 1;
+    }
+    std::vector<FrameTimes> frames;
+    std::string line;
+    std::getline(in, line); // header
+    while(std::getline(in, line)){
+        FrameRecord f;
+        if(!ParseFrame(line, f) || f.swapUs < f.updateStartUs || f.updateEndUs < f.updateStartUs){
+            ofLogError() << "skipping bad frame line " << frames.size() + 2 << " in " << path << std::endl;
+            continue;
+        }
+        frames.push_back(Split(f));
+    }
+    if(frames.empty()){
+        ofLogError() << path << " has no frames" << std::endl;
+        return 1;
+    }
+
+    std::vector<double> intervals;
+    std::array<std::vector<double>, kSections> sections;
+    double totalMs = 0;
+    for(const FrameTimes& t : frames){
+        intervals.push_back(t.intervalMs);
+        totalMs += t.intervalMs;
+        for(int s = 0; s < kSections; ++s) sections[s].push_back(t.sectionMs[s]);
+    }
+    double mean = totalMs / frames.size();
+    double variance = 0;
+    for(double i : intervals) variance += (i - mean) * (i - mean);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << frames.size() << " frames over " << totalMs / 1000.0 << " s, "
+              << 1000.0 * frames.size() / totalMs << " fps, target " << targetFps << "\n";
+    std::cout << "frame interval ms  p50 " << Percentile(intervals, 0.5) << "  p90 " << Percentile(intervals, 0.9)
+              << "  p99 " << Percentile(intervals, 0.99) << "  p99.9 " << Percentile(intervals, 0.999)
+              << "  max " << *std::max_element(intervals.begin(), intervals.end())
+              << "  jitter (stddev) " << std::sqrt(variance / frames.size()) << "\n\n";
+
+    std::array<double, kSections> typical;
+    std::cout << std::left << std::setw(14) << "section" << std::right
+              << std::setw(9) << "p50" << std::setw(9) << "p90" << std::setw(9) << "p99" << std::setw(9) << "max" << "\n";
+    for(int s = 0; s < kSections; ++s){
+        typical[s] = Percentile(sections[s], 0.5);
+        std::cout << std::left << std::setw(14) << FrameSectionToString(FrameSection(s)) << std::right
+                  << std::setw(9) << typical[s] << std::setw(9) << Percentile(sections[s], 0.9)
+                  << std::setw(9) << Percentile(sections[s], 0.99)
+                  << std::setw(9) << *std::max_element(sections[s].begin(), sections[s].end()) << "\n";
+    }
+
+    // a stutter is a frame that ran half a budget late, so at least one vsync got missed
+    // it is blamed on the section that ran furthest over its own typical time
+    double stutterMs = 1.5 * 1000.0 / targetFps;
+    std::vector<size_t> stutters;
+    std::array<int, kSections> blamed = {};
+    std::vector<int> culprit(frames.size(), -1);
+    for(size_t i = 0; i < frames.size(); ++i){
+        if(frames[i].intervalMs <= stutterMs) continue;
+        int worst = 0;
+        for(int s = 1; s < kSections; ++s){
+            if(frames[i].sectionMs[s] - typical[s] > frames[i].sectionMs[worst] - typical[worst]) worst = s;
+        }
+        culprit[i] = worst;
+        ++blamed[worst];
+        stutters.push_back(i);
+    }
+    std::cout << "\n" << stutters.size() << " stutters over " << stutterMs << " ms ("
+              << 100.0 * stutters.size() / frames.size() << "% of frames)\n";
+    for(int s = 0; s < kSections; ++s){
+        if(blamed[s] > 0) std::cout << "  " << std::left << std::setw(14) << FrameSectionToString(FrameSection(s)) << std::right << blamed[s] << "\n";
+    }
+
+    std::sort(stutters.begin(), stutters.end(), [&frames](size_t a, size_t b){ return frames[a].intervalMs > frames[b].intervalMs; });
+    if(stutters.size() > 10) stutters.resize(10);
+    if(!stutters.empty()) std::cout << "\nworst spikes\n";
+    for(size_t i : stutters){
+        const FrameTimes& t = frames[i];
+        std::cout << "  frame " << std::setw(6) << i << std::setw(9) << t.intervalMs << " ms, "
+                  << FrameSectionToString(FrameSection(culprit[i])) << " took " << t.sectionMs[culprit[i]]
+                  << " ms (typically " << typical[culprit[i]] << ")\n";
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// microseconds on the steady clock, what every frame timestamp is measured in
+uint64_t FrameClockMicros();
+
+// where the aquarium's Update() spent its time, filled in by the scene every tick
+struct UpdateBreakdown {
+    uint32_t streamingUs = 0;  // paging regions in and out
+    uint32_t collisionsUs = 0; // player collisions and creature contacts
+    uint32_t simulationUs = 0; // moving every creature
+};
+
+// the parts of a frame a spike can be blamed on
+enum class FrameSection : uint8_t {
+    STREAMING,
+    COLLISIONS,
+    SIMULATION,
+    UPDATE_OTHER, // the rest of update, input, the player, the camera
+    DRAW,
+    PRESENT,      // draw end to the next update, frame limiter wait, buffer swap and OS events
+    COUNT
+};
+
+std::string FrameSectionToString(FrameSection s);
+
+// one frame, swapUs is when the next frame started since openFrameworks has no hook after the swap
+struct FrameRecord {
+    uint64_t updateStartUs = 0;
+    uint64_t updateEndUs = 0;
+    uint64_t drawStartUs = 0;
+    uint64_t drawEndUs = 0;
+    uint64_t swapUs = 0;
+    UpdateBreakdown update;
+};
+
+// timestamps of the latest frames, kept in a buffer allocated up front so recording
+// never allocates or touches the disk while the game runs
+// once full the oldest frames are overwritten, Save() writes what is left in order
+class FramePacingRecorder {
+    public:
+        // 36000 frames is ten minutes at 60fps
+        void Start(size_t capacity = 36000);
+        bool IsRecording() const { return !m_frames.empty(); }
+
+        // call at the very top of update(), it also closes the frame before
+        void BeginUpdate();
+        void EndUpdate(const UpdateBreakdown& parts);
+        void BeginDraw();
+        void EndDraw();
+
+        // csv, one completed frame per line, the format AnalyzeFrameLog reads
+        bool Save(const std::string& path) const;
+        uint64_t GetRecordedCount() const { return m_recorded; }
+
+    private:
+        FrameRecord& current() { return m_frames[(m_recorded - 1) % m_frames.size()]; }
+
+        std::vector<FrameRecord> m_frames;
+        uint64_t m_recorded = 0; // frames started, the one in progress included
+};
+
+// --analyze-frames: percentiles per frame section, stutters over 1.5 frame budgets
+// and what each of the worst spikes went over on
+int AnalyzeFrameLog(const std::string& path, float targetFps = 60);
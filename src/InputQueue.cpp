@@ -0,0 +1,74 @@
+#include "InputQueue.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include "ofMain.h"
+
+
+uint64_t InputClockMicros() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void InputQueue::Push(int key, InputAction action, int player) {
+    InputEvent e;
+    e.timestampUs = InputClockMicros();
+    e.key = key;
+    e.action = action;
+    e.player = player;
+    m_pending.push_back(e);
+}
+
+void InputQueue::consumed(InputEvent& e, uint32_t tick, uint64_t nowUs) {
+    e.tick = tick;
+    uint64_t latency = nowUs > e.timestampUs ? nowUs - e.timestampUs : 0;
+    ++m_drained;
+    m_totalLatencyUs += latency;
+    m_maxLatencyUs = std::max(m_maxLatencyUs, latency);
+    if (m_recording) {
+        m_recorded.push_back(e);
+    }
+}
+
+void InputQueue::StartRecording(unsigned seed) {
+    m_recording = true;
+    m_seed = seed;
+    m_recorded.clear();
+}
+
+// plain text so recordings diff well: a header with the seed, then one "tick key action player" per line
+// version 1 recordings have no player column, everything in them came from the keyboard
+bool InputQueue::SaveRecording(const std::string& path) const {
+    std::ofstream out(path);
+    out << "aquarium-input 2 seed " << m_seed << "\n";
+    for (const InputEvent& e : m_recorded) {
+        out << e.tick << ' ' << e.key << ' ' << (e.action == InputAction::PRESS ? "press" : "release") << ' ' << e.player << "\n";
+    }
+    if (!out) {
+        ofLogError() << "failed to save input recording to " << path << std::endl;
+        return false;
+    }
+    ofLogNotice() << "saved " << m_recorded.size() << " input events to " << path << std::endl;
+    return true;
+}
+
+bool InputQueue::LoadReplay(const std::string& path, unsigned& seed) {
+    std::ifstream in(path);
+    std::string magic, seedLabel;
+    int version = 0;
+    if (!(in >> magic >> version >> seedLabel >> seed) || magic != "aquarium-input" || version < 1 || version > 2) {
+        ofLogError() << path << " is not an input recording" << std::endl;
+        return false;
+    }
+    m_replay.clear();
+    InputEvent e;
+    std::string action;
+    while (in >> e.tick >> e.key >> action && (version < 2 || in >> e.player)) {
+        e.action = action == "press" ? InputAction::PRESS : InputAction::RELEASE;
+        m_replay.push_back(e);
+    }
+    m_replayAt = 0;
+    m_replaying = true;
+    ofLogNotice() << "replaying " << m_replay.size() << " input events from " << path << std::endl;
+    return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+enum class InputAction : uint8_t {
+    PRESS,
+    RELEASE
+};
+
+struct InputEvent {
+    uint64_t timestampUs = 0; // when the key callback fired
+    uint32_t tick = 0;        // simulation tick that consumed it
+    int key = 0;
+    InputAction action = InputAction::PRESS;
+    // -1 for the local keyboard, the key says whose it is
+    // remote inputs name their player and steer with the arrow keys
+    int player = -1;
+};
+
+// key events wait here until the next simulation tick drains them, so the player only ever
+// moves inside the tick no matter how often the OS repeats keys
+// every drained event can be recorded with its tick and replayed later tick for tick
+class InputQueue {
+    public:
+        void Push(int key, InputAction action, int player = -1);
+
+        // hands the events for this tick to apply in arrival order
+        // while replaying, live events are dropped and the recorded ones for this tick are used
+        template<class Fn>
+        void Drain(uint32_t tick, Fn&& apply);
+
+        void StartRecording(unsigned seed);
+        bool SaveRecording(const std::string& path) const;
+        // the seed the recorded session was started with comes back through seed
+        bool LoadReplay(const std::string& path, unsigned& seed);
+        bool IsRecording() const { return m_recording; }
+        bool IsReplaying() const { return m_replaying; }
+
+        // time from the key callback to the tick that applied it
+        uint64_t GetMaxLatencyUs() const { return m_maxLatencyUs; }
+        double GetMeanLatencyUs() const { return m_drained > 0 ? double(m_totalLatencyUs) / m_drained : 0; }
+        uint64_t GetDrainedCount() const { return m_drained; }
+
+    private:
+        void consumed(InputEvent& e, uint32_t tick, uint64_t nowUs);
+
+        std::vector<InputEvent> m_pending;
+        std::vector<InputEvent> m_recorded;
+        std::vector<InputEvent> m_replay;
+        size_t m_replayAt = 0;
+        bool m_recording = false;
+        bool m_replaying = false;
+        unsigned m_seed = 0;
+
+        uint64_t m_drained = 0;
+        uint64_t m_totalLatencyUs = 0;
+        uint64_t m_maxLatencyUs = 0;
+};
+
+uint64_t InputClockMicros();
+
+template<class Fn>
+void InputQueue::Drain(uint32_t tick, Fn&& apply) {
+    uint64_t now = InputClockMicros();
+    if (m_replaying) {
+        m_pending.clear();
+        while (m_replayAt < m_replay.size() && m_replay[m_replayAt].tick <= tick) {
+            InputEvent e = m_replay[m_replayAt++];
+            apply(e);
+        }
+        return;
+    }
+    for (InputEvent& e : m_pending) {
+        consumed(e, tick, now);
+        apply(e);
+    }
+    m_pending.clear();
+}
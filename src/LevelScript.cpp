@@ -0,0 +1,113 @@
+#include "LevelScript.h"
+#include <algorithm>
+#include <exception>
+#include "ofMain.h"
+
+
+void ScriptTask::promise_type::unhandled_exception(){
+    // a broken script ends there, the level keeps going without it
+    try {
+        throw;
+    } catch(const std::exception& e){
+        ofLogError() << "level script stopped: " << e.what() << std::endl;
+    } catch(...){
+        ofLogError() << "level script stopped on an unknown exception" << std::endl;
+    }
+}
+
+
+void ScriptScheduler::Start(ScriptTask task, int group){
+    ScriptTask::Handle handle = task.release();
+    if(!handle) return;
+    int slot;
+    if(!m_freeSlots.empty()){
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        slot = m_slots.size();
+        m_slots.emplace_back();
+    }
+    handle.promise().scheduler = this;
+    handle.promise().slot = slot;
+    m_slots[slot].handle = handle;
+    m_slots[slot].group = group;
+    ++m_running;
+    this->sleep(slot, 0);
+}
+
+void ScriptScheduler::Cancel(int group){
+    for(size_t slot = 0; slot < m_slots.size(); ++slot){
+        if(m_slots[slot].handle && m_slots[slot].group == group) this->release(slot);
+    }
+    // a signal may never be raised again, so its list is pruned here instead of when it wakes
+    // stale timers run out on their own
+    for(auto& waiting : m_waiting){
+        waiting.erase(std::remove_if(waiting.begin(), waiting.end(), [this](const Wakeup& w){
+            return m_slots[w.slot].generation != w.generation;
+        }), waiting.end());
+    }
+}
+
+void ScriptScheduler::CancelAll(){
+    for(size_t slot = 0; slot < m_slots.size(); ++slot){
+        if(m_slots[slot].handle) this->release(slot);
+    }
+    // whatever is still queued points at freed slots, it would only be skipped later
+    m_timers = decltype(m_timers)();
+    for(auto& waiting : m_waiting) waiting.clear();
+    m_signalled.clear();
+}
+
+void ScriptScheduler::Raise(ScriptSignal signal){
+    ++m_raised[int(signal)];
+    std::vector<Wakeup>& waiting = m_waiting[int(signal)];
+    m_signalled.insert(m_signalled.end(), waiting.begin(), waiting.end());
+    waiting.clear();
+}
+
+void ScriptScheduler::Tick(){
+    ++m_tick;
+    m_due.swap(m_signalled);
+    m_signalled.clear();
+    while(!m_timers.empty() && m_timers.top().tick <= m_tick){
+        m_due.push_back(m_timers.top());
+        m_timers.pop();
+    }
+    // scripts going back to sleep from here land on a later tick, so this list does not grow while it runs
+    m_lastResumed = 0;
+    for(const Wakeup& w : m_due){
+        this->resume(w.slot, w.generation);
+    }
+}
+
+void ScriptScheduler::sleep(int slot, uint32_t ticks){
+    m_timers.push(Wakeup{m_tick + std::max<uint32_t>(1, ticks), m_order++, slot, m_slots[slot].generation});
+}
+
+void ScriptScheduler::wait(int slot, ScriptSignal signal){
+    m_slots[slot].raisedBefore = m_raised[int(signal)];
+    m_waiting[int(signal)].push_back(Wakeup{m_tick, m_order++, slot, m_slots[slot].generation});
+}
+
+// counted when the script resumes, so raises after the wakeup was queued are not lost
+uint32_t ScriptScheduler::raisedSince(int slot, ScriptSignal signal) const {
+    return uint32_t(m_raised[int(signal)] - m_slots[slot].raisedBefore);
+}
+
+void ScriptScheduler::resume(int slot, uint32_t generation){
+    Slot& s = m_slots[slot];
+    if(!s.handle || s.generation != generation) return; // cancelled or finished since it went to sleep
+    ++m_lastResumed;
+    ScriptTask::Handle handle = s.handle;
+    handle.resume();
+    if(handle.done()) this->release(slot);
+}
+
+void ScriptScheduler::release(int slot){
+    Slot& s = m_slots[slot];
+    s.handle.destroy();
+    s.handle = nullptr;
+    ++s.generation;
+    m_freeSlots.push_back(slot);
+    --m_running;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <coroutine>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+
+// things a script can wait for besides time, raised by the game and delivered on the next tick
+enum class ScriptSignal : uint8_t {
+    CREATURE_EATEN,   // anything removed from the tank by the player or a predator
+    BOSS_DEFEATED,    // a creature a script spawned with SpawnBoss was eaten
+    COUNT
+};
+
+class ScriptScheduler;
+
+// the return type of a level script, a coroutine that co_awaits the scheduler
+//     ScriptTask Waves(ScriptScheduler& scripts) {
+//         for (;;) { co_await scripts.Ticks(600); ... }
+//     }
+// the frame is owned by the scheduler once started, dropping a task that was never started frees it
+class ScriptTask {
+    public:
+        struct promise_type {
+            ScriptScheduler* scheduler = nullptr;
+            int slot = -1;
+
+            ScriptTask get_return_object() { return ScriptTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; } // runs once the scheduler starts it
+            std::suspend_always final_suspend() noexcept { return {}; }   // the scheduler frees finished frames
+            void return_void() {}
+            void unhandled_exception();
+        };
+        using Handle = std::coroutine_handle<promise_type>;
+
+        ScriptTask(ScriptTask&& other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
+        ScriptTask(const ScriptTask&) = delete;
+        ScriptTask& operator=(const ScriptTask&) = delete;
+        ~ScriptTask() { if (m_handle) m_handle.destroy(); }
+
+    private:
+        friend class ScriptScheduler;
+        explicit ScriptTask(Handle handle) : m_handle(handle) {}
+        Handle release() { Handle h = m_handle; m_handle = nullptr; return h; }
+
+        Handle m_handle;
+};
+
+// runs level scripts, resumed once per simulation tick
+// a waiting script sits in a timer heap or a signal list and costs nothing until it is due,
+// so a tick only pays for the scripts it actually resumes
+// scripts are grouped, usually by level, so a whole level's worth can be cancelled at once
+class ScriptScheduler {
+    public:
+        ScriptScheduler() = default;
+        ScriptScheduler(const ScriptScheduler&) = delete;
+        ScriptScheduler& operator=(const ScriptScheduler&) = delete;
+        ~ScriptScheduler() { this->CancelAll(); }
+
+        // the script runs up to its first wait on the next Tick()
+        void Start(ScriptTask task, int group = 0);
+        // never from inside a script of the group being cancelled
+        void Cancel(int group);
+        void CancelAll();
+        // whatever is waiting on the signal right now wakes up on the next Tick()
+        // raises are counted, so a script woken by several in one tick sees all of them
+        void Raise(ScriptSignal signal);
+        void Tick();
+
+        uint32_t GetTick() const { return m_tick; }
+        int GetRunningCount() const { return m_running; }
+        // scripts resumed by the latest Tick()
+        int GetLastResumedCount() const { return m_lastResumed; }
+
+        // co_await scripts.Ticks(n) sleeps n ticks, 0 still waits for the next one
+        struct TicksAwaiter {
+            ScriptScheduler* scheduler;
+            uint32_t ticks;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(ScriptTask::Handle h) { scheduler->sleep(h.promise().slot, ticks); }
+            void await_resume() const noexcept {}
+        };
+        // co_await scripts.Signal(s) sleeps until someone raises s and gives back how many times
+        // it was raised since the script went to sleep, at least one
+        struct SignalAwaiter {
+            ScriptScheduler* scheduler;
+            ScriptSignal signal;
+            int slot = -1;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(ScriptTask::Handle h) { slot = h.promise().slot; scheduler->wait(slot, signal); }
+            uint32_t await_resume() const noexcept { return scheduler->raisedSince(slot, signal); }
+        };
+        TicksAwaiter Ticks(uint32_t ticks) { return TicksAwaiter{this, ticks}; }
+        SignalAwaiter Signal(ScriptSignal signal) { return SignalAwaiter{this, signal}; }
+
+    private:
+        struct Slot {
+            ScriptTask::Handle handle;
+            int group = 0;
+            uint32_t generation = 0; // bumped when the slot is freed, so stale wakeups are ignored
+            uint64_t raisedBefore = 0; // the signal's raise count when the script started waiting on it
+        };
+        struct Wakeup {
+            uint32_t tick;
+            uint32_t order; // keeps scripts due on the same tick in the order they went to sleep
+            int slot;
+            uint32_t generation;
+            bool operator>(const Wakeup& other) const { return tick != other.tick ? tick > other.tick : order > other.order; }
+        };
+
+        void sleep(int slot, uint32_t ticks);
+        void wait(int slot, ScriptSignal signal);
+        uint32_t raisedSince(int slot, ScriptSignal signal) const;
+        void resume(int slot, uint32_t generation);
+        void release(int slot);
+
+        std::vector<Slot> m_slots;
+        std::vector<int> m_freeSlots;
+        std::priority_queue<Wakeup, std::vector<Wakeup>, std::greater<Wakeup>> m_timers;
+        std::vector<Wakeup> m_waiting[int(ScriptSignal::COUNT)];
+        uint64_t m_raised[int(ScriptSignal::COUNT)] = {};
+        std::vector<Wakeup> m_signalled; // woken by a signal, resumed on the next tick
+        std::vector<Wakeup> m_due;       // reused by Tick()
+        uint32_t m_tick = 0;
+        uint32_t m_order = 0;
+        int m_running = 0;
+        int m_lastResumed = 0;
+};
@@ -0,0 +1,72 @@
+#include "MemoryAccounting.h"
+#include <cstdio>
+
+
+namespace {
+
+struct LedgerEntry {
+    std::atomic<int64_t> bytes{0};
+    std::atomic<int64_t> peakBytes{0};
+    std::atomic<int64_t> allocations{0};
+};
+
+LedgerEntry g_ledger[int(MemorySubsystem::COUNT)];
+
+}
+
+
+std::string MemorySubsystemToString(MemorySubsystem s){
+    switch(s){
+        case MemorySubsystem::CREATURES: return "creatures";
+        case MemorySubsystem::SPRITES: return "sprites";
+        case MemorySubsystem::EVENTS: return "events";
+        case MemorySubsystem::LEVELS: return "levels";
+        case MemorySubsystem::AUDIO: return "audio";
+        default: return "unknown";
+    }
+}
+
+void MemoryLedger::Allocated(MemorySubsystem s, int64_t bytes){
+    LedgerEntry& e = g_ledger[int(s)];
+    int64_t now = e.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    e.allocations.fetch_add(1, std::memory_order_relaxed);
+    int64_t peak = e.peakBytes.load(std::memory_order_relaxed);
+    while(now > peak && !e.peakBytes.compare_exchange_weak(peak, now, std::memory_order_relaxed)){}
+}
+
+void MemoryLedger::Freed(MemorySubsystem s, int64_t bytes){
+    LedgerEntry& e = g_ledger[int(s)];
+    e.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    e.allocations.fetch_sub(1, std::memory_order_relaxed);
+}
+
+MemoryUsage MemoryLedger::Get(MemorySubsystem s){
+    const LedgerEntry& e = g_ledger[int(s)];
+    MemoryUsage usage;
+    usage.bytes = e.bytes.load(std::memory_order_relaxed);
+    usage.peakBytes = e.peakBytes.load(std::memory_order_relaxed);
+    usage.allocations = e.allocations.load(std::memory_order_relaxed);
+    return usage;
+}
+
+int64_t MemoryLedger::GetTotalBytes(){
+    int64_t total = 0;
+    for(int s = 0; s < int(MemorySubsystem::COUNT); ++s){
+        total += g_ledger[s].bytes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void MemoryLedger::WriteReport(std::ostream& out){
+    char line[96];
+    std::snprintf(line, sizeof(line), "%-10s %12s %12s %8s\n", "subsystem", "live KiB", "peak KiB", "allocs");
+    out << line;
+    for(int s = 0; s < int(MemorySubsystem::COUNT); ++s){
+        MemoryUsage u = Get(MemorySubsystem(s));
+        std::snprintf(line, sizeof(line), "%-10s %12.1f %12.1f %8lld\n", MemorySubsystemToString(MemorySubsystem(s)).c_str(),
+            u.bytes / 1024.0, u.peakBytes / 1024.0, (long long)u.allocations);
+        out << line;
+    }
+    std::snprintf(line, sizeof(line), "%-10s %12.1f\n", "total", GetTotalBytes() / 1024.0);
+    out << line;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+
+// who a tracked allocation belongs to
+enum class MemorySubsystem : uint8_t {
+    CREATURES, // creature objects and their shared_ptr control blocks
+    SPRITES,   // sprite images, on the CPU and their textures on the GPU
+    EVENTS,    // game events handed between detection and the scene
+    LEVELS,    // levels and their population nodes
+    AUDIO,     // loaded sounds, estimated from the files
+    COUNT
+};
+
+std::string MemorySubsystemToString(MemorySubsystem s);
+
+struct MemoryUsage {
+    int64_t bytes = 0;       // live right now
+    int64_t peakBytes = 0;
+    int64_t allocations = 0; // live right now
+};
+
+// process wide live byte and allocation counts per subsystem
+// lock free, so it is safe from the batch runner's worker threads
+class MemoryLedger {
+    public:
+        static void Allocated(MemorySubsystem s, int64_t bytes);
+        static void Freed(MemorySubsystem s, int64_t bytes);
+        static MemoryUsage Get(MemorySubsystem s);
+        static int64_t GetTotalBytes();
+        // one line per subsystem plus a total, the same text the overlay shows
+        static void WriteReport(std::ostream& out);
+};
+
+// std::allocator that books what it hands out against a subsystem
+// used through allocate_shared the control block is booked together with the object
+template<class T, MemorySubsystem S>
+struct TrackingAllocator {
+    using value_type = T;
+    template<class U> struct rebind { using other = TrackingAllocator<U, S>; };
+
+    TrackingAllocator() = default;
+    template<class U>
+    TrackingAllocator(const TrackingAllocator<U, S>&) {}
+
+    T* allocate(size_t n) {
+        MemoryLedger::Allocated(S, int64_t(n * sizeof(T)));
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) {
+        MemoryLedger::Freed(S, int64_t(n * sizeof(T)));
+        std::allocator<T>().deallocate(p, n);
+    }
+};
+
+template<class T, class U, MemorySubsystem S>
+bool operator==(const TrackingAllocator<T, S>&, const TrackingAllocator<U, S>&) { return true; }
+template<class T, class U, MemorySubsystem S>
+bool operator!=(const TrackingAllocator<T, S>&, const TrackingAllocator<U, S>&) { return false; }
+
+// make_shared with the allocation booked against S
+template<MemorySubsystem S, class T, class... Args>
+std::shared_ptr<T> MakeTracked(Args&&... args) {
+    return std::allocate_shared<T>(TrackingAllocator<T, S>(), std::forward<Args>(args)...);
+}
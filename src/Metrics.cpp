@@ -0,0 +1,137 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "ofMain.h"
+
+
+namespace {
+
+const char* MetricKindToString(MetricKind kind){
+    return kind == MetricKind::COUNTER ? "counter" : "gauge";
+}
+
+// nearest rank on a sorted window, good enough for a few hundred frames
+float Quantile(const std::vector<float>& sorted, float q){
+    if(sorted.empty()) return 0;
+    size_t rank = size_t(q * (sorted.size() - 1) + 0.5f);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+void WriteSummary(std::ostream& out, const char* name, const char* help, std::vector<float>& ms){
+    std::sort(ms.begin(), ms.end());
+    double sum = 0;
+    for(float v : ms) sum += v;
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " summary\n";
+    const float quantiles[] = {0.5f, 0.9f, 0.99f};
+    for(float q : quantiles){
+        out << name << "{quantile=\"" << q << "\"} " << Quantile(ms, q) / 1000.0f << "\n";
+    }
+    // the sum only ever grows within a window, written in full like the counters (see WriteText)
+    std::streamsize previousPrecision = out.precision(17);
+    out << name << "_sum " << sum / 1000.0 << "\n";
+    out.precision(previousPrecision);
+    out << name << "_count " << ms.size() << "\n";
+}
+
+}
+
+
+Metric& MetricsRegistry::Counter(const std::string& name, const std::string& help, const std::string& labels){
+    m_metrics.emplace_back(name, help, MetricKind::COUNTER, labels);
+    return m_metrics.back();
+}
+
+Metric& MetricsRegistry::Gauge(const std::string& name, const std::string& help, const std::string& labels){
+    m_metrics.emplace_back(name, help, MetricKind::GAUGE, labels);
+    return m_metrics.back();
+}
+
+void MetricsRegistry::WriteText(std::ostream& out) const {
+    // every digit a double has, the default 6 turns a counter past a million into 1.23457e+06
+    // and scrapers see it stand still
+    std::streamsize previousPrecision = out.precision(17);
+    const std::string* lastName = nullptr;
+    for(const Metric& m : m_metrics){
+        if(!lastName || *lastName != m.GetName()){
+            out << "# HELP " << m.GetName() << " " << m.GetHelp() << "\n";
+            out << "# TYPE " << m.GetName() << " " << MetricKindToString(m.GetKind()) << "\n";
+            lastName = &m.GetName();
+        }
+        out << m.GetName();
+        if(!m.GetLabels().empty()){
+            out << "{" << m.GetLabels() << "}";
+        }
+        out << " " << m.Get() << "\n";
+    }
+    out.precision(previousPrecision);
+}
+
+
+void MetricsExporter::Start(const MetricsRegistry& registry, const std::string& path, float periodSeconds){
+    Stop();
+    m_registry = &registry;
+    m_path = path;
+    m_periodSeconds = std::max(0.1f, periodSeconds);
+    m_stopping = false;
+    m_thread = std::thread([this](){ this->run(); });
+    ofLogNotice() << "exporting metrics to " << m_path << " every " << m_periodSeconds << "s" << std::endl;
+}
+
+void MetricsExporter::Stop(){
+    if(!m_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void MetricsExporter::run(){
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    while(!m_stopping){
+        m_wake.wait_for(lock, std::chrono::duration<float>(m_periodSeconds), [this](){ return m_stopping; });
+        lock.unlock();
+        exportOnce(); // the last one on the way out catches the final frames
+        lock.lock();
+    }
+}
+
+void MetricsExporter::exportOnce(){
+    auto start = std::chrono::steady_clock::now();
+    m_tickMs.clear();
+    m_drawMs.clear();
+    FrameSample sample;
+    while(m_samples.Pop(sample)){
+        m_tickMs.push_back(sample.tickMs);
+        m_drawMs.push_back(sample.drawMs);
+    }
+
+    std::string tmpPath = m_path + ".tmp";
+    {
+        std::ofstream out(tmpPath);
+        m_registry->WriteText(out);
+        WriteSummary(out, "aquarium_tick_seconds", "Simulation tick time over the last export window.", m_tickMs);
+        WriteSummary(out, "aquarium_draw_seconds", "Frame draw time over the last export window.", m_drawMs);
+        out << "# HELP aquarium_metrics_dropped_samples_total Frame samples lost to a full ring.\n";
+        out << "# TYPE aquarium_metrics_dropped_samples_total counter\n";
+        out << "aquarium_metrics_dropped_samples_total " << m_samples.GetDropped() << "\n";
+        out << "# HELP aquarium_metrics_export_seconds Time the previous export took.\n";
+        out << "# TYPE aquarium_metrics_export_seconds gauge\n";
+        out << "aquarium_metrics_export_seconds " << m_lastExportMs / 1000.0 << "\n";
+        if(!out){
+            ofLogError() << "failed to write metrics to " << tmpPath << std::endl;
+            return;
+        }
+    }
+    std::error_code err;
+    std::filesystem::rename(tmpPath, m_path, err);
+    if(err){
+        ofLogError() << "failed to publish metrics to " << m_path << ": " << err.message() << std::endl;
+    }
+    m_lastExportMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
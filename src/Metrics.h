@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+enum class MetricKind {
+    COUNTER,
+    GAUGE
+};
+
+// one named value, written by the game thread and read by the exporter thread
+// there is a single writer, so a relaxed load and store is all an add needs
+class Metric {
+    public:
+        Metric(std::string name, std::string help, MetricKind kind, std::string labels)
+        : m_name(std::move(name)), m_help(std::move(help)), m_labels(std::move(labels)), m_kind(kind) {}
+
+        void Add(double amount = 1) { m_value.store(m_value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed); }
+        void Set(double value) { m_value.store(value, std::memory_order_relaxed); }
+        double Get() const { return m_value.load(std::memory_order_relaxed); }
+
+        const std::string& GetName() const { return m_name; }
+        const std::string& GetHelp() const { return m_help; }
+        const std::string& GetLabels() const { return m_labels; }
+        MetricKind GetKind() const { return m_kind; }
+
+    private:
+        std::string m_name;
+        std::string m_help;
+        std::string m_labels; // already formatted, like type="FastFish"
+        MetricKind m_kind;
+        std::atomic<double> m_value{0};
+};
+
+// owns every metric of the process, register them all before the exporter starts
+// metrics sharing a name (one per label set) should be registered next to each other
+class MetricsRegistry {
+    public:
+        Metric& Counter(const std::string& name, const std::string& help, const std::string& labels = "");
+        Metric& Gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+        // Prometheus text exposition format
+        void WriteText(std::ostream& out) const;
+
+    private:
+        std::deque<Metric> m_metrics; // a deque so handed out references stay put
+};
+
+
+// fixed size single producer single consumer queue, neither side ever blocks
+// a push into a full ring is dropped and counted instead of waiting for the reader
+template<class T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "ring size must be a power of two");
+    public:
+        bool Push(const T& item) {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            if (head - m_tail.load(std::memory_order_acquire) == N) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            m_items[head & (N - 1)] = item;
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+        bool Pop(T& item) {
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail == m_head.load(std::memory_order_acquire)) return false;
+            item = m_items[tail & (N - 1)];
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+        uint64_t GetDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    private:
+        T m_items[N];
+        std::atomic<size_t> m_head{0};
+        std::atomic<size_t> m_tail{0};
+        std::atomic<uint64_t> m_dropped{0};
+};
+
+// what the game thread hands over every frame, the exporter turns these into percentiles
+struct FrameSample {
+    float tickMs = 0;
+    float drawMs = 0;
+};
+
+// writes the registry plus tick and draw time summaries to a file every period, from its own thread
+// the file is replaced in one rename so a scraper never reads half of it
+class MetricsExporter {
+    public:
+        ~MetricsExporter() { Stop(); }
+        void Start(const MetricsRegistry& registry, const std::string& path, float periodSeconds);
+        void Stop();
+        bool IsRunning() const { return m_thread.joinable(); }
+
+        // game thread only
+        void Record(const FrameSample& sample) { m_samples.Push(sample); }
+
+    private:
+        void run();
+        void exportOnce();
+
+        const MetricsRegistry* m_registry = nullptr;
+        std::string m_path;
+        float m_periodSeconds = 5;
+        // ten seconds of frames at 60 fps, the exporter empties it well before that
+        SpscRing<FrameSample, 1024> m_samples;
+        std::vector<float> m_tickMs;
+        std::vector<float> m_drawMs;
+        double m_lastExportMs = 0;
+
+        std::thread m_thread;
+        std::mutex m_wakeMutex;
+        std::condition_variable m_wake;
+        bool m_stopping = false;
+};
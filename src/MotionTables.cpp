@@ -0,0 +1,113 @@
+#include "MotionTables.h"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include "ofMain.h"
+
+
+MotionTable MotionTables::s_tables[MotionTables::kMaxPatterns];
+
+namespace {
+
+std::vector<std::string> g_patternNames;
+
+void Bake(const MotionPatternDef& def, MotionTable& table){
+    int keys = def.keys.size();
+    for(int i = 0; i < MotionTable::kSize; ++i){
+        float at = float(i) * keys / MotionTable::kSize;
+        int key = int(at);
+        float value = def.keys[key];
+        if(def.interpolation == MotionInterpolation::LINEAR){
+            float next = def.keys[(key + 1) % keys];
+            value += (next - value) * (at - key);
+        }
+        table.values[i] = value * def.amplitude;
+    }
+    table.step = MotionTable::kSize / std::max(1.0f, def.periodTicks);
+}
+
+// the two patterns the game has always had, so nothing depends on the data file being there
+// written in the data file's own format and read by the same parser, so the file's copy of them
+// (bin/data/motion-patterns.txt) and these give the very same tables
+const char* kBuiltInPatterns =
+    // one sine wave per 2 pi / 0.05 ticks, what stepping sin() by 0.05 a tick used to give
+    "bob 125.6637 1.8 linear "
+        "0.0000 0.0980 0.1951 0.2903 0.3827 0.4714 0.5556 0.6344 0.7071 0.7730 0.8315 0.8819 0.9239 0.9569 0.9808 0.9952 "
+        "1.0000 0.9952 0.9808 0.9569 0.9239 0.8819 0.8315 0.7730 0.7071 0.6344 0.5556 0.4714 0.3827 0.2903 0.1951 0.0980 "
+        "0.0000 -0.0980 -0.1951 -0.2903 -0.3827 -0.4714 -0.5556 -0.6344 -0.7071 -0.7730 -0.8315 -0.8819 -0.9239 -0.9569 -0.9808 -0.9952 "
+        "-1.0000 -0.9952 -0.9808 -0.9569 -0.9239 -0.8819 -0.8315 -0.7730 -0.7071 -0.6344 -0.5556 -0.4714 -0.3827 -0.2903 -0.1951 -0.0980\n"
+    "zigzag 30 0.9 step 1 -1\n";
+
+struct BuiltInPatterns {
+    BuiltInPatterns(){
+        std::istringstream in(kBuiltInPatterns);
+        MotionTables::Load(in, "built in motion patterns");
+    }
+} g_builtInPatterns;
+
+}
+
+
+int MotionTables::Define(const MotionPatternDef& def){
+    if(def.keys.empty()){
+        ofLogError() << "motion pattern " << def.name << " has no keys" << std::endl;
+        return -1;
+    }
+    int id = Find(def.name);
+    if(id < 0){
+        if(int(g_patternNames.size()) >= kMaxPatterns){
+            ofLogError() << "no room for motion pattern " << def.name << std::endl;
+            return -1;
+        }
+        id = g_patternNames.size();
+        g_patternNames.push_back(def.name);
+    }
+    Bake(def, s_tables[id]);
+    return id;
+}
+
+int MotionTables::Find(const std::string& name){
+    for(size_t i = 0; i < g_patternNames.size(); ++i){
+        if(g_patternNames[i] == name) return i;
+    }
+    return -1;
+}
+
+int MotionTables::GetCount(){
+    return g_patternNames.size();
+}
+
+int MotionTables::LoadFile(const std::string& path){
+    std::ifstream in(path);
+    if(!in){
+        return 0;
+    }
+    int defined = Load(in, path);
+    ofLogNotice() << "loaded " << defined << " motion patterns from " << path << std::endl;
+    return defined;
+}
+
+int MotionTables::Load(std::istream& in, const std::string& source){
+    int defined = 0;
+    std::string line;
+    int lineNumber = 0;
+    while(std::getline(in, line)){
+        ++lineNumber;
+        if(line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        MotionPatternDef def;
+        std::string interpolation;
+        if(!(fields >> def.name >> def.periodTicks >> def.amplitude >> interpolation)
+           || (interpolation != "step" && interpolation != "linear")){
+            ofLogError() << source << ":" << lineNumber << " is not a motion pattern" << std::endl;
+            continue;
+        }
+        def.interpolation = interpolation == "step" ? MotionInterpolation::STEP : MotionInterpolation::LINEAR;
+        float key;
+        while(fields >> key){
+            def.keys.push_back(key);
+        }
+        if(Define(def) >= 0) ++defined;
+    }
+    return defined;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+
+// one periodic motion pattern baked into a fixed size table, so a creature following it
+// costs a table read per tick instead of a sin() or a modulo
+// phase is measured in table entries and wraps at kSize
+struct MotionTable {
+    static const int kSize = 256;
+    float values[kSize] = {};
+    float step = 1.0f; // phase advance per tick, kSize / period in ticks
+
+    float sample(float phase) const { return values[int(phase) & (kSize - 1)]; }
+    float advance(float phase) const {
+        phase += step;
+        return phase >= kSize ? phase - kSize : phase;
+    }
+    // several ticks at once, for creatures stepped at a reduced rate
+    float advance(float phase, int ticks) const { return std::fmod(phase + step * ticks, float(kSize)); }
+};
+
+enum class MotionInterpolation {
+    STEP,   // hold each key until the next one, for square waves like the fast fish zig-zag
+    LINEAR  // blend between keys, for smooth ones like the jellyfish bob
+};
+
+// a pattern as data: the keys are spread evenly over one period and scaled by the amplitude
+struct MotionPatternDef {
+    std::string name;
+    float periodTicks = 60;
+    float amplitude = 1;
+    MotionInterpolation interpolation = MotionInterpolation::LINEAR;
+    std::vector<float> keys;
+};
+
+// every pattern the kinematics can use, creatures refer to them by id
+// the built in ones always exist, a data file can replace them or add more
+// define patterns at startup only, the tables are read without locks while the game runs
+class MotionTables {
+    public:
+        static const int kMaxPatterns = 32;
+        static const int kBob = 0;    // jellyfish drifting up and down
+        static const int kZigZag = 1; // fast fish darting up and down every half second
+
+        // returns the id, a name that is already defined keeps its id and gets the new table
+        // -1 when the table is full or the definition has no keys
+        static int Define(const MotionPatternDef& def);
+        static int Find(const std::string& name);
+        static int GetCount();
+
+        // one pattern per line: name period_ticks amplitude step|linear key key ...
+        // blank lines and lines starting with # are skipped, returns how many were defined
+        static int LoadFile(const std::string& path);
+        // the same from any stream, source names it in the error messages
+        static int Load(std::istream& in, const std::string& source);
+
+        static const MotionTable& Get(int id) { return s_tables[id]; }
+
+    private:
+        static MotionTable s_tables[kMaxPatterns];
+};
@@ -0,0 +1,174 @@
+#include "RemoteInput.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include "Aquarium.h"
+
+
+namespace {
+
+const uint8_t kVersion = 1;
+const int kHostWindowWidth = 1024;
+const int kHostWindowHeight = 768;
+const int kHostWorldScale = 2;
+const int kHostPlayerSpeed = 5;
+
+sockaddr_in LoopbackAddress(int port){
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(uint16_t(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+}
+
+
+bool RemoteInputServer::Open(int port){
+    this->Close();
+    m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if(m_socket < 0){
+        ofLogError() << "remote input: no socket" << std::endl;
+        return false;
+    }
+    sockaddr_in address = LoopbackAddress(port);
+    if(bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0){
+        ofLogError() << "remote input: port " << port << " is taken" << std::endl;
+        this->Close();
+        return false;
+    }
+    fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL, 0) | O_NONBLOCK);
+    ofLogNotice() << "remote input listening on 127.0.0.1:" << port << std::endl;
+    return true;
+}
+
+void RemoteInputServer::Close(){
+    if(m_socket >= 0) close(m_socket);
+    m_socket = -1;
+}
+
+int RemoteInputServer::Poll(InputQueue& queue){
+    if(m_socket < 0) return 0;
+    int pushed = 0;
+    uint8_t packet[kPacketSize + 1]; // one more, so a longer datagram shows up as one
+    for(;;){
+        ssize_t got = recv(m_socket, packet, sizeof(packet), 0);
+        if(got < 0) break; // nothing left, or the socket went bad, either way try again next tick
+        if(got != kPacketSize || packet[0] != 'A' || packet[1] != 'Q' || packet[2] != kVersion){
+            ++m_rejected;
+            continue;
+        }
+        int key = int16_t(packet[4] | (packet[5] << 8));
+        InputAction action = packet[6] ? InputAction::RELEASE : InputAction::PRESS;
+        queue.Push(key, action, packet[3]);
+        ++m_received;
+        ++pushed;
+    }
+    return pushed;
+}
+
+
+bool RemoteInputClient::Connect(int port){
+    this->Close();
+    m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address = LoopbackAddress(port);
+    if(m_socket < 0 || connect(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0){
+        ofLogError() << "remote input: cannot reach 127.0.0.1:" << port << std::endl;
+        this->Close();
+        return false;
+    }
+    return true;
+}
+
+void RemoteInputClient::Close(){
+    if(m_socket >= 0) close(m_socket);
+    m_socket = -1;
+}
+
+bool RemoteInputClient::Send(int player, int key, InputAction action){
+    if(m_socket < 0) return false;
+    uint8_t packet[RemoteInputServer::kPacketSize] = {
+        'A', 'Q', kVersion, uint8_t(player),
+        uint8_t(key & 0xff), uint8_t((key >> 8) & 0xff),
+        uint8_t(action == InputAction::RELEASE ? 1 : 0), 0
+    };
+    return send(m_socket, packet, sizeof(packet), 0) == ssize_t(sizeof(packet));
+}
+
+
+int RunInputHost(int port, int players, int ticks){
+    RemoteInputServer server;
+    if(!server.Open(port)) return 1;
+    players = std::max(1, players);
+
+    int worldWidth = kHostWindowWidth * kHostWorldScale;
+    int worldHeight = kHostWindowHeight * kHostWorldScale;
+    auto aquarium = std::make_shared<Aquarium>(worldWidth, worldHeight, nullptr);
+    AddDefaultAquariumLevels(aquarium);
+    std::shared_ptr<AquariumGameScene> scene;
+    for(int p = 0; p < players; ++p){
+        // side by side around the middle, every one of them is steered from the network
+        float x = worldWidth / 2 - 50 + (p - players / 2) * 120;
+        auto player = MakeTracked<MemorySubsystem::CREATURES, PlayerCreature>(x, worldHeight / 2 - 50, kHostPlayerSpeed, nullptr);
+        player->setDirection(0, 0);
+        if(scene == nullptr){
+            scene = std::make_shared<AquariumGameScene>(player, aquarium, "host");
+        } else {
+            scene->AddPlayer(player, PlayerKeys{});
+        }
+    }
+    scene->GetCamera().setViewport(kHostWindowWidth, kHostWindowHeight);
+    aquarium->Repopulate();
+
+    // real time, so clients started by hand have something to steer
+    ofLogLevel previousLevel = ofGetLogLevel();
+    ofSetLogLevel(OF_LOG_WARNING);
+    auto next = std::chrono::steady_clock::now();
+    double updateUs = 0;
+    int ran = 0;
+    for(; ran < ticks; ++ran){
+        next += std::chrono::microseconds(1000000 / kAquariumTicksPerSecond);
+        server.Poll(scene->GetInput());
+        auto start = std::chrono::steady_clock::now();
+        scene->Update();
+        updateUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        if(scene->GetLastEvent() != nullptr && scene->GetLastEvent()->isGameOver()) { ++ran; break; }
+        std::this_thread::sleep_until(next);
+    }
+    ofSetLogLevel(previousLevel);
+
+    std::printf("ticks %d, creatures %d, update %.1f us/tick, remote events %llu, rejected %llu\n",
+        ran, aquarium->getCreatureCount(), ran > 0 ? updateUs / ran : 0.0,
+        (unsigned long long)server.GetReceivedCount(), (unsigned long long)server.GetRejectedCount());
+    std::printf("player,x,y,score,power,lives\n");
+    for(int p = 0; p < scene->GetPlayerCount(); ++p){
+        const PlayerCreature& player = *scene->GetPlayer(p);
+        std::printf("%d,%.0f,%.0f,%d,%d,%d\n", p, player.getX(), player.getY(), player.getScore(), player.getPower(), player.getLives());
+    }
+    return 0;
+}
+
+int RunInputClient(int port, int player, int seconds){
+    RemoteInputClient client;
+    if(!client.Connect(port)) return 1;
+    // a new heading every half second, the last key is let go before the next one goes down
+    const int keys[] = {OF_KEY_UP, OF_KEY_DOWN, OF_KEY_LEFT, OF_KEY_RIGHT};
+    std::mt19937 rng(4800 + player);
+    int held = 0;
+    int sent = 0;
+    for(int step = 0; step < seconds * 2; ++step){
+        if(held != 0 && client.Send(player, held, InputAction::RELEASE)) ++sent;
+        held = keys[rng() % 4];
+        if(client.Send(player, held, InputAction::PRESS)) ++sent;
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+    if(held != 0 && client.Send(player, held, InputAction::RELEASE)) ++sent;
+    std::printf("player %d: sent %d events\n", player, sent);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "InputQueue.h"
+
+
+// key events from other processes on the same machine, one small UDP datagram per event
+// the game polls the socket once per tick and feeds what arrived into its InputQueue,
+// where it is drained, recorded and replayed like the keyboard
+// datagrams: 'A' 'Q', version, player, key as little endian int16, action, one spare byte
+class RemoteInputServer {
+    public:
+        static const int kPacketSize = 8;
+
+        RemoteInputServer() = default;
+        RemoteInputServer(const RemoteInputServer&) = delete;
+        RemoteInputServer& operator=(const RemoteInputServer&) = delete;
+        ~RemoteInputServer() { this->Close(); }
+
+        // listens on 127.0.0.1 only, the socket never blocks
+        bool Open(int port);
+        void Close();
+        bool IsOpen() const { return m_socket >= 0; }
+
+        // pushes everything that arrived since the last poll, returns how many events that was
+        int Poll(InputQueue& queue);
+        uint64_t GetReceivedCount() const { return m_received; }
+        uint64_t GetRejectedCount() const { return m_rejected; }
+
+    private:
+        int m_socket = -1;
+        uint64_t m_received = 0;
+        uint64_t m_rejected = 0; // wrong size or magic
+};
+
+class RemoteInputClient {
+    public:
+        RemoteInputClient() = default;
+        RemoteInputClient(const RemoteInputClient&) = delete;
+        RemoteInputClient& operator=(const RemoteInputClient&) = delete;
+        ~RemoteInputClient() { this->Close(); }
+
+        bool Connect(int port);
+        void Close();
+        // key is one of the arrow keys, the server side steers player with it
+        bool Send(int player, int key, InputAction action);
+
+    private:
+        int m_socket = -1;
+};
+
+
+// headless stand ins for extra players, --input-host runs a game that only remote clients steer,
+// --input-client steers one of its players at random for a while
+int RunInputHost(int port, int players, int ticks);
+int RunInputClient(int port, int player, int seconds);
@@ -0,0 +1,435 @@
+#include "SimulationFuzz.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <random>
+#include <sstream>
+
+
+namespace {
+
+enum class FuzzOp {
+    TICK,
+    RAISE_POPULATION,
+    LOWER_POPULATION,
+    SPAWN,
+    BOSS,
+    REMOVE,
+    REMOVE_MISSING,
+    ADD_FOREIGN,
+    COLLIDE,
+    CONTACTS,
+    EFFECT,
+    RESIZE,
+    TOGGLE,
+    COMPLETE_LEVEL,
+    COUNT
+};
+
+const char* FuzzOpToString(FuzzOp op){
+    switch(op){
+        case FuzzOp::TICK: return "tick";
+        case FuzzOp::RAISE_POPULATION: return "raise population";
+        case FuzzOp::LOWER_POPULATION: return "lower population";
+        case FuzzOp::SPAWN: return "spawn";
+        case FuzzOp::BOSS: return "boss";
+        case FuzzOp::REMOVE: return "remove";
+        case FuzzOp::REMOVE_MISSING: return "remove missing";
+        case FuzzOp::ADD_FOREIGN: return "add player";
+        case FuzzOp::COLLIDE: return "collide";
+        case FuzzOp::CONTACTS: return "contacts";
+        case FuzzOp::EFFECT: return "effect";
+        case FuzzOp::RESIZE: return "resize";
+        case FuzzOp::TOGGLE: return "toggle";
+        case FuzzOp::COMPLETE_LEVEL: return "complete level";
+        default: return "unknown";
+    }
+}
+
+// how often each op comes up, ticks most since that is where everything meets
+const int kOpWeights[int(FuzzOp::COUNT)] = {40, 6, 4, 3, 2, 10, 2, 1, 12, 6, 4, 3, 2, 1};
+
+// spawnable kinds, powerups included, so everything MakeCreature knows gets exercised
+const AquariumCreatureType kFuzzTypes[] = {
+    AquariumCreatureType::NPCreature, AquariumCreatureType::BiggerFish, AquariumCreatureType::JellyFish,
+    AquariumCreatureType::FastFish, AquariumCreatureType::PowerUp
+};
+
+const int kMinWorld = 400; // a scaled up boss still fits between the walls
+const int kMaxWorld = 4096;
+const int kRecentKept = 12;
+
+struct FuzzState {
+    std::mt19937 rng;
+    std::shared_ptr<Aquarium> aquarium;
+    std::shared_ptr<PlayerCreature> player;
+    std::vector<std::shared_ptr<PlayerCreature>> players;
+    std::vector<std::shared_ptr<GameEvent>> hits;
+    std::vector<int> nearby;
+    bool settled = true;             // false between a resize and the next move
+    int64_t trackedBefore = 0;
+    std::deque<std::string> recent;
+
+    int pick(int n){ return n > 0 ? int(rng() % unsigned(n)) : 0; }
+    AquariumCreatureType pickType(){ return kFuzzTypes[pick(5)]; }
+    std::shared_ptr<Creature> pickCreature(){
+        int count = aquarium->getCreatureCount();
+        return count > 0 ? aquarium->getCreatureAt(pick(count)) : nullptr;
+    }
+};
+
+FuzzOp PickOp(FuzzState& s){
+    int total = 0;
+    for(int w : kOpWeights) total += w;
+    int roll = s.pick(total);
+    for(int op = 0; op < int(FuzzOp::COUNT); ++op){
+        if(roll < kOpWeights[op]) return FuzzOp(op);
+        roll -= kOpWeights[op];
+    }
+    return FuzzOp::TICK;
+}
+
+// does one op, returns what it did for the report
+std::string Apply(FuzzState& s, FuzzOp op){
+    Aquarium& aquarium = *s.aquarium;
+    std::shared_ptr<AquariumLevel> level = aquarium.getActiveLevel();
+    std::ostringstream did;
+    did << FuzzOpToString(op);
+    switch(op){
+        case FuzzOp::TICK: {
+            int ticks = 1 + s.pick(30);
+            for(int t = 0; t < ticks; ++t) aquarium.update();
+            s.settled = true;
+            did << " x" << ticks;
+            break;
+        }
+        case FuzzOp::RAISE_POPULATION:
+        case FuzzOp::LOWER_POPULATION: {
+            // the way level scripts spawn, the fish come with the next repopulation
+            if(level == nullptr) break;
+            AquariumCreatureType type = s.pickType();
+            int delta = (1 + s.pick(25)) * (op == FuzzOp::RAISE_POPULATION ? 1 : -1);
+            level->AddPopulation(type, delta);
+            did << " " << AquariumCreatureTypeToString(type) << " " << delta;
+            break;
+        }
+        case FuzzOp::SPAWN: {
+            // straight into the tank is only for tanks without levels, with levels they would not be counted
+            if(level != nullptr){
+                aquarium.Repopulate();
+                did << " (repopulate)";
+                break;
+            }
+            std::vector<AquariumCreatureType> batch(1 + s.pick(60));
+            for(AquariumCreatureType& type : batch) type = s.pickType();
+            aquarium.SpawnCreatures(batch);
+            did << " " << batch.size();
+            break;
+        }
+        case FuzzOp::BOSS: {
+            float scale = 1.5f + s.pick(16) / 10.0f;
+            aquarium.SpawnBoss(s.pick(2) ? AquariumCreatureType::BiggerFish : AquariumCreatureType::JellyFish, scale);
+            did << " x" << scale;
+            break;
+        }
+        case FuzzOp::REMOVE: {
+            // the player eating a few at once
+            int count = 1 + s.pick(5);
+            for(int i = 0; i < count; ++i){
+                std::shared_ptr<Creature> c = s.pickCreature();
+                if(c == nullptr) break;
+                aquarium.removeCreature(c);
+            }
+            did << " " << count;
+            break;
+        }
+        case FuzzOp::REMOVE_MISSING: {
+            // a fish that never made it into the tank, or the player
+            std::shared_ptr<Creature> stranger = s.pick(2) ? aquarium.MakeCreature(s.pickType(), 0, 0, 1) : nullptr;
+            aquarium.removeCreature(stranger ? stranger : std::static_pointer_cast<Creature>(s.player));
+            break;
+        }
+        case FuzzOp::ADD_FOREIGN:
+            aquarium.addCreature(s.player);
+            break;
+        case FuzzOp::COLLIDE: {
+            // the player swims a stretch and eats what it ran into, like AquariumGameScene does
+            std::uniform_real_distribution<float> x(0, aquarium.getWidth());
+            std::uniform_real_distribution<float> y(0, aquarium.getHeight());
+            std::shared_ptr<Creature> target = s.pick(2) ? s.pickCreature() : nullptr;
+            float toX = target ? target->getX() : x(s.rng);
+            float toY = target ? target->getY() : y(s.rng);
+            s.player->setPosition(x(s.rng), y(s.rng));
+            s.player->setDirection(toX - s.player->getX(), toY - s.player->getY());
+            int steps = 1 + s.pick(20);
+            int eaten = 0;
+            for(int step = 0; step < steps; ++step){
+                s.player->update(aquarium.getBounds());
+                DetectAquariumCollisions(aquarium, s.players, s.hits, s.nearby);
+                for(const std::shared_ptr<GameEvent>& hit : s.hits){
+                    aquarium.removeCreature(hit->creatureB);
+                    ++eaten;
+                }
+                s.hits.clear();
+                s.player->markCollisionCheckpoint();
+                aquarium.markCollisionCheckpoint();
+            }
+            did << " " << steps << " steps, ate " << eaten;
+            break;
+        }
+        case FuzzOp::CONTACTS: {
+            int iterations = 1 + s.pick(8);
+            int contacts = aquarium.ResolveContacts(iterations);
+            aquarium.markCollisionCheckpoint();
+            did << " " << iterations << " iterations, " << contacts << " contacts";
+            break;
+        }
+        case FuzzOp::EFFECT: {
+            std::shared_ptr<Creature> c = s.pick(3) ? s.pickCreature() : std::static_pointer_cast<Creature>(s.player);
+            if(c == nullptr) break;
+            EffectGrant grant = PowerUp::RandomGrant();
+            grant.ticks = 1 + s.pick(600);
+            aquarium.getEffects().Apply(*c, grant);
+            did << " " << EffectKindToString(grant.kind) << " for " << grant.ticks;
+            break;
+        }
+        case FuzzOp::RESIZE: {
+            int w = kMinWorld + s.pick(kMaxWorld - kMinWorld);
+            int h = kMinWorld + s.pick(kMaxWorld - kMinWorld);
+            aquarium.setBounds(w, h);
+            s.settled = false;
+            did << " " << w << "x" << h;
+            break;
+        }
+        case FuzzOp::TOGGLE:
+            switch(s.pick(3)){
+                case 0: aquarium.setSchoolingEnabled(!aquarium.isSchoolingEnabled()); did << " schooling"; break;
+                case 1: aquarium.setEcosystemEnabled(!aquarium.isEcosystemEnabled()); did << " ecosystem"; break;
+                default:
+                    aquarium.setBroadphase(aquarium.getBroadphase().GetKind() == BroadphaseKind::BRUTE_FORCE
+                        ? BroadphaseKind::SWEEP_AND_PRUNE : BroadphaseKind::BRUTE_FORCE);
+                    did << " broadphase";
+                    break;
+            }
+            break;
+        case FuzzOp::COMPLETE_LEVEL:
+            if(level == nullptr) break;
+            level->AddScore(1000000);
+            aquarium.Repopulate();
+            did << " now on " << aquarium.getCurrentLevel();
+            break;
+        default:
+            break;
+    }
+    return did.str();
+}
+
+// the first broken invariant, empty when they all hold
+std::string CheckInvariants(FuzzState& s){
+    const Aquarium& aquarium = *s.aquarium;
+    const std::vector<std::shared_ptr<Creature>>& creatures = aquarium.getCreatures();
+    std::ostringstream broken;
+
+    if(s.settled){
+        const float slack = 0.01f;
+        for(const std::shared_ptr<Creature>& c : creatures){
+            if(!(c->getX() >= -slack && c->getX() <= aquarium.getWidth() + slack
+                 && c->getY() >= -slack && c->getY() <= aquarium.getHeight() + slack)){
+                broken << AquariumCreatureTypeToString(static_cast<const NPCreature&>(*c).GetType()) << " at ("
+                       << c->getX() << ", " << c->getY() << ") outside " << aquarium.getWidth() << "x" << aquarium.getHeight();
+                return broken.str();
+            }
+        }
+    }
+
+    std::shared_ptr<AquariumLevel> level = aquarium.getActiveLevel();
+    if(level != nullptr){
+        std::array<int, kAquariumCreatureTypeCount> inTank{};
+        for(const std::shared_ptr<Creature>& c : creatures){
+            const NPCreature& npc = static_cast<const NPCreature&>(*c);
+            if(!npc.isBoss()) ++inTank[int(npc.GetType())];
+        }
+        std::array<int, kAquariumCreatureTypeCount> counted{};
+        for(const std::shared_ptr<AquariumLevelPopulationNode>& node : level->GetPopulation()){
+            if(node->currentPopulation < 0){
+                broken << AquariumCreatureTypeToString(node->creatureType) << " population went negative";
+                return broken.str();
+            }
+            counted[int(node->creatureType)] += node->currentPopulation;
+        }
+        for(int t = 0; t < kAquariumCreatureTypeCount; ++t){
+            if(inTank[t] != counted[t]){
+                broken << inTank[t] << " " << AquariumCreatureTypeToString(AquariumCreatureType(t))
+                       << " in the tank, level " << aquarium.getCurrentLevel() << " counts " << counted[t];
+                return broken.str();
+            }
+        }
+    }
+
+    int64_t tracked = MemoryLedger::Get(MemorySubsystem::CREATURES).allocations - s.trackedBefore;
+    if(tracked != int64_t(creatures.size()) + 1){
+        broken << tracked << " tracked creatures alive, " << creatures.size() << " in the tank and the player";
+        return broken.str();
+    }
+
+    // the kinematic batches hold exactly the tank, or someone moves twice or not at all
+    if(s.aquarium->getBatchedCount() != creatures.size()){
+        broken << s.aquarium->getBatchedCount() << " creatures in the kinematic batches, " << creatures.size() << " in the tank";
+        return broken.str();
+    }
+    for(const std::shared_ptr<Creature>& c : creatures){
+        if(c->getKinematicSlot() < 0){
+            broken << "a creature in the tank is in no kinematic batch";
+            return broken.str();
+        }
+    }
+
+    int affected = s.aquarium->getEffects().GetAffectedCount();
+    int withEffects = s.aquarium->getEffects().Get(*s.player).active != 0 ? 1 : 0;
+    for(const std::shared_ptr<Creature>& c : creatures){
+        if(s.aquarium->getEffects().Get(*c).active != 0) ++withEffects;
+    }
+    if(affected != withEffects){
+        broken << affected << " creatures have effects, " << withEffects << " of them are still around";
+        return broken.str();
+    }
+    return "";
+}
+
+}
+
+
+FuzzSequenceResult RunFuzzSequence(unsigned seed, int steps){
+    FuzzSequenceResult result;
+    result.seed = seed;
+    FuzzState s;
+    s.rng.seed(seed);
+    SeedCreatureRandom(seed);
+    s.trackedBefore = MemoryLedger::Get(MemorySubsystem::CREATURES).allocations;
+
+    {
+        int w = kMinWorld + s.pick(kMaxWorld - kMinWorld);
+        int h = kMinWorld + s.pick(kMaxWorld - kMinWorld);
+        s.aquarium = std::make_shared<Aquarium>(w, h, nullptr);
+        // one in eight has no levels at all, removals there used to divide by zero
+        if(s.pick(8) != 0) AddDefaultAquariumLevels(s.aquarium);
+        s.aquarium->setSchoolingEnabled(s.pick(2));
+        s.aquarium->setEcosystemEnabled(s.pick(2));
+        s.player = MakeTracked<MemorySubsystem::CREATURES, PlayerCreature>(w / 2.0f, h / 2.0f, 5, nullptr);
+        s.players.push_back(s.player);
+        s.aquarium->Repopulate();
+
+        for(; result.steps < steps; ++result.steps){
+            FuzzOp op = PickOp(s);
+            s.recent.push_back(Apply(s, op));
+            if(s.recent.size() > size_t(kRecentKept)) s.recent.pop_front();
+            std::string broken = CheckInvariants(s);
+            if(broken.empty()) continue;
+            ++result.violations;
+            std::ostringstream report;
+            report << "step " << result.steps << ": " << broken << "\n  after:";
+            for(const std::string& did : s.recent) report << " [" << did << "]";
+            result.violation = report.str();
+            break;
+        }
+        s.players.clear();
+        s.player.reset();
+        s.aquarium.reset();
+    }
+
+    // with the tank gone every creature it made should be too
+    int64_t leaked = MemoryLedger::Get(MemorySubsystem::CREATURES).allocations - s.trackedBefore;
+    if(leaked != 0 && result.violations == 0){
+        ++result.violations;
+        result.violation = std::to_string(leaked) + " creatures outlived their aquarium";
+    }
+    return result;
+}
+
+int RunSimulationFuzz(const FuzzConfig& config){
+    // refused adds and the like are expected here, only what the harness finds is worth printing
+    ofLogLevel previousLevel = ofGetLogLevel();
+    ofSetLogLevel(OF_LOG_FATAL_ERROR);
+    auto start = std::chrono::steady_clock::now();
+    long long totalSteps = 0;
+    int failed = 0;
+    for(int i = 0; i < config.sequences; ++i){
+        unsigned seed = config.baseSeed + i;
+        FuzzSequenceResult result = RunFuzzSequence(seed, config.steps);
+        totalSteps += result.steps;
+        if(result.violations == 0) continue;
+        ++failed;
+        std::printf("seed %u failed at %s\n  replay with --fuzz 1 %d %u\n",
+            seed, result.violation.c_str(), config.steps, seed);
+    }
+    ofSetLogLevel(previousLevel);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%d sequences, %lld steps in %.2f s (%.0f steps/s), %d failed\n",
+        config.sequences, totalSteps, seconds, totalSteps / std::max(seconds, 1e-9), failed);
+    return failed > 0 ? 1 : 0;
+}
+
+int RunRegionRoundTripCheck(){
+    const float side = 4096;
+    const float far = 3500; // six regions out, well past what stays resident around the origin
+    std::string directory = (std::filesystem::temp_directory_path() / "aquarium-region-check").string();
+    Aquarium aquarium(side, side, nullptr);
+    aquarium.enableRegionStreaming(directory, 512, 1);
+    aquarium.StreamRegions(256, 256);
+
+    std::vector<KinematicState> sent;
+    std::vector<int> speeds;
+    for(int t = 0; t < kAquariumCreatureTypeCount; ++t){
+        std::shared_ptr<NPCreature> creature = aquarium.MakeCreature(AquariumCreatureType(t), far, far, 7);
+        KinematicState state = creature->getKinematicState();
+        state.dx = 0.6f;
+        state.dy = -0.8f;
+        state.phase = 1.25f + t;
+        creature->setKinematicState(state);
+        // not the pattern the type starts with, like one a data file handed out
+        creature->setMotionPattern((creature->getMotionPattern() + 1) % MotionTables::GetCount());
+        state.pattern = uint8_t(creature->getMotionPattern());
+        if(creature->GetType() == AquariumCreatureType::PowerUp){
+            // the last kind, so a fresh roll is unlikely to come up with it by chance
+            std::static_pointer_cast<PowerUp>(creature)->setGrant(PowerUp::GrantFor(EffectKind::SCORE));
+        }
+        sent.push_back(state);
+        speeds.push_back(creature->getSpeed());
+        aquarium.addCreature(creature);
+    }
+    aquarium.StreamRegions(768, 256); // out, the focus has to change region for it to happen now
+    int stored = aquarium.getRegionStore().GetStoredCreatureCount();
+    aquarium.StreamRegions(far, far); // and back in
+
+    int failed = 0;
+    if(stored != kAquariumCreatureTypeCount || aquarium.getCreatureCount() != kAquariumCreatureTypeCount){
+        std::printf("%d creatures went to disk and %d came back, expected %d\n",
+            stored, aquarium.getCreatureCount(), kAquariumCreatureTypeCount);
+        ++failed;
+    }
+    std::printf("%-10s %12s %16s %14s %10s\n", "type", "speed", "heading", "phase", "pattern");
+    for(const std::shared_ptr<Creature>& c : aquarium.getCreatures()){
+        int t = int(static_cast<const NPCreature&>(*c).GetType());
+        KinematicState got = c->getKinematicState();
+        const KinematicState& want = sent[t];
+        // the heading goes through 16 bits per axis on disk
+        bool same = c->getSpeed() == speeds[t] && got.phase == want.phase && got.pattern == want.pattern
+                 && std::abs(got.dx - want.dx) < 1e-4f && std::abs(got.dy - want.dy) < 1e-4f;
+        if(t == int(AquariumCreatureType::PowerUp)){
+            EffectKind kind = static_cast<const PowerUp&>(*c).getGrant().kind;
+            if(kind != EffectKind::SCORE){
+                std::printf("the power up came back handing out %s\n", EffectKindToString(kind));
+                same = false;
+            }
+        }
+        std::printf("%-10s %5d -> %-4d %6.3f,%6.3f %5.2f -> %-5.2f %3d -> %-3d %s\n",
+            AquariumCreatureTypeToString(AquariumCreatureType(t)).c_str(), speeds[t], c->getSpeed(),
+            got.dx, got.dy, want.phase, got.phase, want.pattern, got.pattern, same ? "" : "CHANGED");
+        if(!same) ++failed;
+    }
+    std::error_code err;
+    std::filesystem::remove_all(directory, err);
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include "Aquarium.h"
+
+
+// randomized sequences of whatever the game does to the tank (ticks, spawns, removals, collisions,
+// bosses, effects, resizes, level changes) run headless as fast as they go, with the invariants
+// checked after every step:
+//   every creature's centre is inside the world, once it has moved since the last resize
+//   per type, the fish in the tank are what the level's population nodes say are out
+//   live tracked creatures are the tank plus the player, nothing else holds on to one
+//   every creature with timed effects is in the tank or is the player
+//   the kinematic batches hold exactly the creatures in the tank
+// sequence i runs from seed baseSeed + i, so --fuzz 1 steps seed replays a failing one alone
+
+struct FuzzConfig {
+    int sequences = 200;
+    int steps = 2000;
+    unsigned baseSeed = 5000;
+};
+
+struct FuzzSequenceResult {
+    unsigned seed = 0;
+    int steps = 0;          // steps run, a sequence stops at its first violation
+    int violations = 0;
+    std::string violation;  // the first one, with the steps that led to it
+};
+
+FuzzSequenceResult RunFuzzSequence(unsigned seed, int steps);
+
+// every sequence, a line per failing one and a summary, non zero if anything failed
+int RunSimulationFuzz(const FuzzConfig& config);
+
+// one creature of every type streamed out to disk and back, non zero if one comes back
+// with a different speed, heading, motion phase, motion pattern or power up grant
+int RunRegionRoundTripCheck();
@@ -0,0 +1,492 @@
+#include "SnapshotNet.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include "Aquarium.h"
+
+
+namespace {
+
+const uint8_t kVersion = 1;
+const uint8_t kNoPlayer = 255;
+const size_t kMaxFrame = 1 << 20;
+const size_t kMaxOutbox = 256 * 1024; // past this a client is too far behind and is dropped
+
+const int kServeWindowWidth = 1024;
+const int kServeWindowHeight = 768;
+const int kServeWorldScale = 2;
+const int kServePlayerSpeed = 5;
+const int kServeTicksPerSnapshot = kAquariumTicksPerSecond / 30; // 30 snapshots a second
+const float kTicksPerSecond = float(kAquariumTicksPerSecond);
+const int kWatchFramesPerSecond = 60;
+
+#ifdef MSG_NOSIGNAL
+const int kSendFlags = MSG_NOSIGNAL;
+#else
+const int kSendFlags = 0;
+#endif
+
+using NetClock = std::chrono::steady_clock;
+
+uint64_t NetClockMicros(){
+    return std::chrono::duration_cast<std::chrono::microseconds>(NetClock::now().time_since_epoch()).count();
+}
+
+sockaddr_in LoopbackAddress(int port){
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(uint16_t(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+// non blocking, no Nagle delay and no SIGPIPE when the other end went away
+void PrepareSocket(int s){
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+    int on = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+#ifdef SO_NOSIGPIPE
+    setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+void AppendFrame(std::vector<uint8_t>& out, uint8_t kind, const uint8_t* payload, size_t size){
+    uint32_t length = size + 1;
+    for(int b = 0; b < 4; ++b) out.push_back(uint8_t(length >> (8 * b)));
+    out.push_back(kind);
+    out.insert(out.end(), payload, payload + size);
+}
+
+// calls handle(kind, payload, size) for every whole frame and drops them from the buffer
+// returns false on a frame no peer of ours would send
+template<class Fn>
+bool TakeFrames(std::vector<uint8_t>& inbox, Fn&& handle){
+    size_t at = 0;
+    while(inbox.size() - at >= 4){
+        uint32_t length = inbox[at] | (inbox[at + 1] << 8) | (inbox[at + 2] << 16) | (uint32_t(inbox[at + 3]) << 24);
+        if(length == 0 || length > kMaxFrame) return false;
+        if(inbox.size() - at - 4 < length) break;
+        handle(inbox[at + 4], inbox.data() + at + 5, size_t(length - 1));
+        at += 4 + length;
+    }
+    inbox.erase(inbox.begin(), inbox.begin() + at);
+    return true;
+}
+
+// appends what the socket has, false once it is closed or broken
+bool ReadAvailable(int s, std::vector<uint8_t>& inbox, uint64_t* counted = nullptr){
+    uint8_t buffer[16384];
+    for(;;){
+        ssize_t got = recv(s, buffer, sizeof(buffer), 0);
+        if(got > 0){
+            inbox.insert(inbox.end(), buffer, buffer + got);
+            if(counted) *counted += got;
+            continue;
+        }
+        if(got == 0) return false;
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+}
+
+void PutU32(std::vector<uint8_t>& out, uint32_t v){
+    for(int b = 0; b < 4; ++b) out.push_back(uint8_t(v >> (8 * b)));
+}
+
+uint32_t GetU32(const uint8_t* p){
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+}
+
+}
+
+
+bool SnapshotServer::Open(int port, int worldWidth, int worldHeight, int playerSlots, int ticksPerSnapshot){
+    this->Close();
+    m_worldWidth = worldWidth;
+    m_worldHeight = worldHeight;
+    m_ticksPerSnapshot = std::max(1, ticksPerSnapshot);
+    m_slotTaken.assign(std::max(0, playerSlots), false);
+    m_listen = socket(AF_INET, SOCK_STREAM, 0);
+    if(m_listen < 0){
+        ofLogError() << "snapshot server: no socket" << std::endl;
+        return false;
+    }
+    int on = 1;
+    setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in address = LoopbackAddress(port);
+    if(bind(m_listen, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(m_listen, 16) != 0){
+        ofLogError() << "snapshot server: port " << port << " is taken" << std::endl;
+        this->Close();
+        return false;
+    }
+    socklen_t length = sizeof(address);
+    getsockname(m_listen, reinterpret_cast<sockaddr*>(&address), &length);
+    m_port = ntohs(address.sin_port);
+    fcntl(m_listen, F_SETFL, fcntl(m_listen, F_GETFL, 0) | O_NONBLOCK);
+    ofLogNotice() << "snapshot server listening on 127.0.0.1:" << m_port << std::endl;
+    return true;
+}
+
+void SnapshotServer::Close(){
+    for(auto& c : m_clients) this->drop(*c);
+    m_clients.clear();
+    m_departed.clear();
+    if(m_listen >= 0) close(m_listen);
+    m_listen = -1;
+    m_port = 0;
+    m_sent.Clear();
+}
+
+void SnapshotServer::Poll(InputQueue& input){
+    if(m_listen < 0) return;
+    this->accept();
+    for(auto& c : m_clients){
+        this->read(*c, input);
+        if(!c->closed) this->flush(*c);
+    }
+    m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(),
+        [this](const std::unique_ptr<Connection>& c){
+            if(c->closed) m_departed.push_back(c->stats);
+            return c->closed;
+        }), m_clients.end());
+}
+
+void SnapshotServer::accept(){
+    for(;;){
+        int s = ::accept(m_listen, nullptr, nullptr);
+        if(s < 0) return;
+        PrepareSocket(s);
+        auto c = std::make_unique<Connection>();
+        c->socket = s;
+        for(size_t slot = 0; slot < m_slotTaken.size(); ++slot){
+            if(m_slotTaken[slot]) continue;
+            m_slotTaken[slot] = true;
+            c->stats.player = slot;
+            break;
+        }
+        std::vector<uint8_t> hello = {kVersion, uint8_t(c->stats.player < 0 ? kNoPlayer : c->stats.player),
+            uint8_t(m_ticksPerSnapshot)};
+        PutU32(hello, m_worldWidth);
+        PutU32(hello, m_worldHeight);
+        this->queue(*c, 'H', hello.data(), hello.size());
+        ofLogNotice() << "snapshot client joined as " << (c->stats.player < 0 ? string("a watcher") : "player " + ofToString(c->stats.player)) << std::endl;
+        m_clients.push_back(std::move(c));
+    }
+}
+
+void SnapshotServer::read(Connection& c, InputQueue& input){
+    bool open = ReadAvailable(c.socket, c.inbox);
+    bool sane = TakeFrames(c.inbox, [&](uint8_t kind, const uint8_t* payload, size_t size){
+        if(kind == 'A' && size == 4){
+            c.acked = std::max(c.acked, GetU32(payload));
+        } else if(kind == 'I' && size == 3 && c.stats.player >= 0){
+            int key = int16_t(payload[0] | (payload[1] << 8));
+            input.Push(key, payload[2] ? InputAction::RELEASE : InputAction::PRESS, c.stats.player);
+        }
+    });
+    if(!open || !sane) this->drop(c);
+}
+
+void SnapshotServer::Broadcast(const Snapshot& snapshot){
+    m_encoded.clear();
+    for(auto& c : m_clients){
+        if(c->closed) continue;
+        if(!c->outbox.empty()){
+            // still sending the last one, the next one after it deltas from whatever was acked by then
+            ++c->stats.skipped;
+            continue;
+        }
+        const Snapshot* baseline = m_sent.Find(c->acked);
+        uint32_t baselineTick = baseline ? baseline->tick : 0;
+        auto shared = std::find_if(m_encoded.begin(), m_encoded.end(),
+            [&](const std::pair<uint32_t, std::vector<uint8_t>>& e){ return e.first == baselineTick; });
+        if(shared == m_encoded.end()){
+            uint64_t start = NetClockMicros();
+            m_encoded.emplace_back(baselineTick, std::vector<uint8_t>());
+            EncodeSnapshot(snapshot, baseline, m_encoded.back().second);
+            c->stats.encodeUs += NetClockMicros() - start;
+            shared = m_encoded.end() - 1;
+        }
+        this->queue(*c, 'S', shared->second.data(), shared->second.size());
+        ++c->stats.snapshotsSent;
+        if(baseline == nullptr) ++c->stats.fullSnapshots;
+        this->flush(*c);
+    }
+    m_sent.Add(snapshot);
+}
+
+std::vector<SnapshotClientStats> SnapshotServer::GetClientStats() const {
+    std::vector<SnapshotClientStats> stats = m_departed;
+    for(const auto& c : m_clients) stats.push_back(c->stats);
+    return stats;
+}
+
+void SnapshotServer::queue(Connection& c, uint8_t kind, const uint8_t* payload, size_t size){
+    AppendFrame(c.outbox, kind, payload, size);
+}
+
+void SnapshotServer::flush(Connection& c){
+    if(c.outbox.empty()) return;
+    ssize_t sent = ::send(c.socket, c.outbox.data(), c.outbox.size(), kSendFlags);
+    if(sent > 0){
+        c.stats.bytesSent += sent;
+        c.outbox.erase(c.outbox.begin(), c.outbox.begin() + sent);
+    } else if(sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+        this->drop(c);
+        return;
+    }
+    if(c.outbox.size() > kMaxOutbox) this->drop(c);
+}
+
+void SnapshotServer::drop(Connection& c){
+    if(c.closed) return;
+    c.closed = true;
+    close(c.socket);
+    if(c.stats.player >= 0 && size_t(c.stats.player) < m_slotTaken.size()) m_slotTaken[c.stats.player] = false;
+    ofLogNotice() << "snapshot client left after " << c.stats.bytesSent << " bytes" << std::endl;
+}
+
+
+bool SnapshotClient::Connect(int port){
+    this->Close();
+    m_socket = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = LoopbackAddress(port);
+    if(m_socket < 0 || connect(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0){
+        this->Close();
+        return false;
+    }
+    PrepareSocket(m_socket);
+    return true;
+}
+
+void SnapshotClient::Close(){
+    if(m_socket >= 0) close(m_socket);
+    m_socket = -1;
+    m_inbox.clear();
+    m_history.Clear();
+    m_player = -1;
+}
+
+bool SnapshotClient::Poll(){
+    if(m_socket < 0) return false;
+    bool open = ReadAvailable(m_socket, m_inbox, &m_bytesReceived);
+    bool sane = TakeFrames(m_inbox, [this](uint8_t kind, const uint8_t* payload, size_t size){
+        this->handle(kind, payload, size);
+    });
+    if(!open || !sane){
+        ofLogNotice() << "snapshot server went away" << std::endl;
+        this->Close();
+        return false;
+    }
+    return true;
+}
+
+void SnapshotClient::handle(uint8_t kind, const uint8_t* payload, size_t size){
+    if(kind == 'H' && size == 11 && payload[0] == kVersion){
+        m_player = payload[1] == kNoPlayer ? -1 : payload[1];
+        m_ticksPerSnapshot = std::max<int>(1, payload[2]);
+        m_worldWidth = GetU32(payload + 3);
+        m_worldHeight = GetU32(payload + 7);
+        return;
+    }
+    if(kind != 'S') return;
+    uint64_t start = NetClockMicros();
+    uint32_t baselineTick = 0;
+    bool decoded = ReadBaselineTick(payload, size, baselineTick)
+                && DecodeSnapshot(payload, size, m_history.Find(baselineTick), m_decoded);
+    m_decodeUs += NetClockMicros() - start;
+    if(!decoded){
+        // nothing is acked, so the next one comes against an older baseline or in full
+        ++m_failed;
+        return;
+    }
+    ++m_snapshots;
+    m_latestArrivalUs = NetClockMicros();
+    uint8_t ack[4];
+    for(int b = 0; b < 4; ++b) ack[b] = uint8_t(m_decoded.tick >> (8 * b));
+    m_history.Add(m_decoded);
+    this->send('A', ack, sizeof(ack));
+}
+
+bool SnapshotClient::SendInput(int key, InputAction action){
+    if(m_socket < 0 || m_player < 0) return false;
+    uint8_t payload[3] = {uint8_t(key & 0xff), uint8_t((key >> 8) & 0xff), uint8_t(action == InputAction::RELEASE ? 1 : 0)};
+    this->send('I', payload, sizeof(payload));
+    return true;
+}
+
+void SnapshotClient::send(uint8_t kind, const uint8_t* payload, size_t size){
+    // tiny frames, if the socket cannot take one the connection is as good as gone
+    std::vector<uint8_t> frame;
+    AppendFrame(frame, kind, payload, size);
+    ::send(m_socket, frame.data(), frame.size(), kSendFlags);
+}
+
+float SnapshotClient::GetRenderTick() const {
+    const Snapshot* latest = m_history.Latest();
+    if(latest == nullptr) return 0;
+    float sinceArrival = (NetClockMicros() - m_latestArrivalUs) * kTicksPerSecond / 1e6f;
+    float delay = 2.0f * m_ticksPerSnapshot;
+    return latest->tick - delay + std::min(sinceArrival, delay);
+}
+
+
+SnapshotViewScene::SnapshotViewScene(string name, std::shared_ptr<AquariumSpriteManager> sprites, int port)
+: m_name(name), m_sprites(std::move(sprites)), m_port(port) {}
+
+void SnapshotViewScene::Update(){
+    if(!m_client.IsConnected()){
+        // once a second until the server is up
+        if(--m_retryCountdown > 0) return;
+        m_retryCountdown = 60;
+        if(!m_client.Connect(m_port)) return;
+        ofLogNotice() << "connected to the snapshot server on port " << m_port << std::endl;
+    }
+    m_client.Poll();
+}
+
+void SnapshotViewScene::Draw(){
+    if(m_client.GetHistory().Latest() == nullptr){
+        ofDrawBitmapString(m_client.IsConnected() ? "waiting for the first snapshot" : "waiting for the server", 20, 20);
+        return;
+    }
+    m_client.GetHistory().Sample(m_client.GetRenderTick(), m_drawn);
+
+    // follow our own player, or look at the middle of the tank when we only watch
+    float focusX = m_client.GetWorldWidth() / 2.0f;
+    float focusY = m_client.GetWorldHeight() / 2.0f;
+    for(const InterpolatedEntity& e : m_drawn){
+        if(m_client.GetPlayer() >= 0 && e.type == kSnapshotPlayerType + m_client.GetPlayer()){
+            focusX = e.x;
+            focusY = e.y;
+        }
+    }
+    m_camera.setWorld(m_client.GetWorldWidth(), m_client.GetWorldHeight());
+    m_camera.follow(focusX, focusY);
+
+    const ofColor tints[] = {ofColor::white, ofColor::orange, ofColor::cyan, ofColor::magenta, ofColor::yellow};
+    m_camera.begin();
+    for(const InterpolatedEntity& e : m_drawn){
+        if(!m_camera.isVisible(e.x, e.y, 150)) continue;
+        bool player = e.type >= kSnapshotPlayerType;
+        AquariumCreatureType type = player ? AquariumCreatureType::NPCreature : AquariumCreatureType(std::min<int>(e.type, kAquariumCreatureTypeCount - 1));
+        std::shared_ptr<GameSprite> sprite = m_sprites ? m_sprites->GetSprite(type) : nullptr;
+        if(sprite == nullptr) continue;
+        ofSetColor(player ? tints[(e.type - kSnapshotPlayerType) % 5] : ofColor::white);
+        sprite->draw(e.x, e.y, e.flipped, e.scale);
+    }
+    ofSetColor(ofColor::white);
+    m_camera.end();
+}
+
+
+int RunSnapshotServer(int port, int players, int ticks){
+    int worldWidth = kServeWindowWidth * kServeWorldScale;
+    int worldHeight = kServeWindowHeight * kServeWorldScale;
+    players = std::max(1, players);
+    SnapshotServer server;
+    if(!server.Open(port, worldWidth, worldHeight, players, kServeTicksPerSnapshot)) return 1;
+
+    auto aquarium = std::make_shared<Aquarium>(worldWidth, worldHeight, nullptr);
+    AddDefaultAquariumLevels(aquarium);
+    std::shared_ptr<AquariumGameScene> scene;
+    for(int p = 0; p < players; ++p){
+        float x = worldWidth / 2 - 50 + (p - players / 2) * 120;
+        auto player = MakeTracked<MemorySubsystem::CREATURES, PlayerCreature>(x, worldHeight / 2 - 50, kServePlayerSpeed, nullptr);
+        player->setDirection(0, 0);
+        if(scene == nullptr){
+            scene = std::make_shared<AquariumGameScene>(player, aquarium, "server");
+        } else {
+            scene->AddPlayer(player, PlayerKeys{});
+        }
+    }
+    scene->GetCamera().setViewport(kServeWindowWidth, kServeWindowHeight);
+    aquarium->Repopulate();
+
+    ofLogLevel previousLevel = ofGetLogLevel();
+    ofSetLogLevel(OF_LOG_WARNING);
+    Snapshot snapshot;
+    double simulationUs = 0, captureUs = 0, broadcastUs = 0;
+    auto next = NetClock::now();
+    int ran = 0;
+    for(; ran < ticks; ++ran){
+        next += std::chrono::microseconds(int(1e6f / kTicksPerSecond));
+        server.Poll(scene->GetInput());
+        uint64_t start = NetClockMicros();
+        scene->Update();
+        simulationUs += NetClockMicros() - start;
+        if(ran % kServeTicksPerSnapshot == 0){
+            start = NetClockMicros();
+            // tick 0 means no baseline on the wire, so snapshots count from 1
+            CaptureSnapshot(*aquarium, scene->GetPlayers(), ran + 1, snapshot);
+            uint64_t captured = NetClockMicros();
+            server.Broadcast(snapshot);
+            captureUs += captured - start;
+            broadcastUs += NetClockMicros() - captured;
+        }
+        if(scene->GetLastEvent() != nullptr && scene->GetLastEvent()->isGameOver()){ ++ran; break; }
+        std::this_thread::sleep_until(next);
+    }
+    ofSetLogLevel(previousLevel);
+
+    float seconds = std::max(1, ran) / kTicksPerSecond;
+    int snapshots = (ran + kServeTicksPerSnapshot - 1) / kServeTicksPerSnapshot;
+    std::printf("ticks %d, entities %d, simulation %.1f us/tick, capture %.1f us/snapshot, send %.1f us/snapshot\n",
+        ran, int(snapshot.entities.size()), simulationUs / std::max(1, ran),
+        captureUs / std::max(1, snapshots), broadcastUs / std::max(1, snapshots));
+    std::printf("client,player,kB_per_s,bytes_per_snapshot,snapshots,full,skipped,encode_us_per_snapshot\n");
+    std::vector<SnapshotClientStats> stats = server.GetClientStats();
+    for(size_t i = 0; i < stats.size(); ++i){
+        const SnapshotClientStats& s = stats[i];
+        std::printf("%d,%d,%.2f,%.1f,%llu,%llu,%llu,%.2f\n", int(i), s.player, s.bytesSent / 1024.0 / seconds,
+            s.snapshotsSent > 0 ? double(s.bytesSent) / s.snapshotsSent : 0.0,
+            (unsigned long long)s.snapshotsSent, (unsigned long long)s.fullSnapshots, (unsigned long long)s.skipped,
+            s.snapshotsSent > 0 ? s.encodeUs / s.snapshotsSent : 0.0);
+    }
+    return 0;
+}
+
+int RunSnapshotWatcher(int port, int seconds){
+    SnapshotClient client;
+    if(!client.Connect(port)){
+        ofLogError() << "no snapshot server on 127.0.0.1:" << port << std::endl;
+        return 1;
+    }
+    // steers its player, if it got one, the way --input-client does
+    const int keys[] = {OF_KEY_UP, OF_KEY_DOWN, OF_KEY_LEFT, OF_KEY_RIGHT};
+    std::mt19937 rng(4900);
+    int held = 0;
+    std::vector<InterpolatedEntity> drawn;
+    double sampleUs = 0;
+    int frames = 0;
+    auto next = NetClock::now();
+    for(; frames < seconds * kWatchFramesPerSecond; ++frames){
+        next += std::chrono::microseconds(1000000 / kWatchFramesPerSecond);
+        if(!client.Poll()) break;
+        uint64_t start = NetClockMicros();
+        client.GetHistory().Sample(client.GetRenderTick(), drawn);
+        sampleUs += NetClockMicros() - start;
+        if(frames % 30 == 0 && client.GetPlayer() >= 0){
+            if(held != 0) client.SendInput(held, InputAction::RELEASE);
+            held = keys[rng() % 4];
+            client.SendInput(held, InputAction::PRESS);
+        }
+        std::this_thread::sleep_until(next);
+    }
+    float elapsed = std::max(1, frames) / float(kWatchFramesPerSecond);
+    const Snapshot* latest = client.GetHistory().Latest();
+    std::printf("player %d: %.2f kB/s, %.1f snapshots/s, decode %.2f us/snapshot, interpolate %.2f us/frame, %d entities at tick %u, %llu failed\n",
+        client.GetPlayer(), client.GetBytesReceived() / 1024.0 / elapsed, client.GetSnapshotCount() / elapsed,
+        client.GetSnapshotCount() > 0 ? client.GetDecodeUs() / client.GetSnapshotCount() : 0.0,
+        frames > 0 ? sampleUs / frames : 0.0, int(drawn.size()), latest ? latest->tick : 0u,
+        (unsigned long long)client.GetFailedCount());
+    return 0;
+}
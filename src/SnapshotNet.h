@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Core.h"
+#include "InputQueue.h"
+#include "Snapshots.h"
+
+class AquariumSpriteManager;
+
+
+// the simulation runs on a server, render clients get snapshots over tcp on 127.0.0.1
+// frames both ways are a little endian u32 length, a kind byte and the payload
+//   server: 'H' hello (player index or 255, world size, ticks per snapshot), 'S' an encoded snapshot
+//   client: 'A' the tick of the latest snapshot it decoded, 'I' a key event for its player
+// every snapshot is a delta against the latest one the client acknowledged, so a client that falls
+// behind or drops a frame still gets something it can decode
+
+struct SnapshotClientStats {
+    int player = -1;             // -1 for clients that only watch
+    uint64_t bytesSent = 0;
+    uint64_t snapshotsSent = 0;
+    uint64_t fullSnapshots = 0;  // sent without a baseline
+    uint64_t skipped = 0;        // not sent because the previous one was still queued
+    double encodeUs = 0;         // encoding done for this client, shared encodings count once
+};
+
+class SnapshotServer {
+    public:
+        SnapshotServer() = default;
+        SnapshotServer(const SnapshotServer&) = delete;
+        SnapshotServer& operator=(const SnapshotServer&) = delete;
+        ~SnapshotServer() { this->Close(); }
+
+        // playerSlots clients get a player each in the order they connect, the rest watch
+        // port 0 lets the system pick a free one, GetPort() says which
+        bool Open(int port, int worldWidth, int worldHeight, int playerSlots, int ticksPerSnapshot);
+        void Close();
+        int GetPort() const { return m_port; }
+
+        // takes new connections and reads acks and key events, the keys go to the client's player
+        void Poll(InputQueue& input);
+        void Broadcast(const Snapshot& snapshot);
+
+        int GetClientCount() const { return m_clients.size(); }
+        // clients that left first, then the ones still here, in the order they joined
+        std::vector<SnapshotClientStats> GetClientStats() const;
+
+    private:
+        struct Connection {
+            int socket = -1;
+            uint32_t acked = 0;
+            bool closed = false;
+            std::vector<uint8_t> inbox;
+            std::vector<uint8_t> outbox; // what the socket would not take yet
+            SnapshotClientStats stats;
+        };
+        void accept();
+        void read(Connection& c, InputQueue& input);
+        void queue(Connection& c, uint8_t kind, const uint8_t* payload, size_t size);
+        void flush(Connection& c);
+        void drop(Connection& c);
+
+        int m_listen = -1;
+        int m_port = 0;
+        int m_worldWidth = 0;
+        int m_worldHeight = 0;
+        int m_ticksPerSnapshot = 1;
+        std::vector<bool> m_slotTaken;
+        std::vector<std::unique_ptr<Connection>> m_clients;
+        std::vector<SnapshotClientStats> m_departed;
+        SnapshotHistory m_sent; // the baselines clients can ack
+        // encodings of the current broadcast by baseline tick, clients on the same baseline share one
+        std::vector<std::pair<uint32_t, std::vector<uint8_t>>> m_encoded;
+};
+
+class SnapshotClient {
+    public:
+        SnapshotClient() = default;
+        SnapshotClient(const SnapshotClient&) = delete;
+        SnapshotClient& operator=(const SnapshotClient&) = delete;
+        ~SnapshotClient() { this->Close(); }
+
+        bool Connect(int port);
+        void Close();
+        bool IsConnected() const { return m_socket >= 0; }
+
+        // reads what arrived, decodes and acks the snapshots, false once the server is gone
+        bool Poll();
+        bool SendInput(int key, InputAction action);
+
+        const SnapshotHistory& GetHistory() const { return m_history; }
+        // where to sample the history now: two snapshots behind the newest, moving on with the local
+        // clock in between so the picture does not stop and jump with every arrival
+        float GetRenderTick() const;
+        int GetPlayer() const { return m_player; }
+        int GetWorldWidth() const { return m_worldWidth; }
+        int GetWorldHeight() const { return m_worldHeight; }
+
+        uint64_t GetBytesReceived() const { return m_bytesReceived; }
+        uint64_t GetSnapshotCount() const { return m_snapshots; }
+        uint64_t GetFailedCount() const { return m_failed; }
+        double GetDecodeUs() const { return m_decodeUs; }
+
+    private:
+        void handle(uint8_t kind, const uint8_t* payload, size_t size);
+        void send(uint8_t kind, const uint8_t* payload, size_t size);
+
+        int m_socket = -1;
+        std::vector<uint8_t> m_inbox;
+        SnapshotHistory m_history;
+        Snapshot m_decoded;
+        int m_player = -1;
+        int m_worldWidth = 0;
+        int m_worldHeight = 0;
+        int m_ticksPerSnapshot = 1;
+        uint64_t m_latestArrivalUs = 0;
+        uint64_t m_bytesReceived = 0;
+        uint64_t m_snapshots = 0;
+        uint64_t m_failed = 0;
+        double m_decodeUs = 0;
+};
+
+
+// a render client as a scene, the tank it draws is whatever the server last sent
+// arrow keys steer the player the server handed this client, if it got one
+class SnapshotViewScene : public GameScene {
+    public:
+        SnapshotViewScene(string name, std::shared_ptr<AquariumSpriteManager> sprites, int port);
+        string GetName() override { return m_name; }
+        void Update() override;
+        void Draw() override;
+        void SendKey(int key, InputAction action) { m_client.SendInput(key, action); }
+        GameCamera& GetCamera() { return m_camera; }
+    private:
+        string m_name;
+        std::shared_ptr<AquariumSpriteManager> m_sprites;
+        int m_port;
+        int m_retryCountdown = 0;
+        SnapshotClient m_client;
+        GameCamera m_camera;
+        std::vector<InterpolatedEntity> m_drawn;
+};
+
+
+// headless ends of the above: --serve runs the game for clients to steer and watch,
+// --watch is a render client that draws nothing and reports what receiving cost it
+int RunSnapshotServer(int port, int players, int ticks);
+int RunSnapshotWatcher(int port, int seconds);
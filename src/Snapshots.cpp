@@ -0,0 +1,285 @@
+#include "Snapshots.h"
+#include <algorithm>
+#include "Aquarium.h"
+
+
+namespace {
+
+const uint8_t kFormat = 1;
+
+// field mask of an entity in a delta
+const uint8_t kNew = 1;
+const uint8_t kMovedX = 2;
+const uint8_t kMovedY = 4;
+const uint8_t kLooks = 8; // type, flags or scale
+
+void PutVarint(std::vector<uint8_t>& out, uint32_t v){
+    while(v >= 0x80){
+        out.push_back(uint8_t(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+}
+
+void PutZigzag(std::vector<uint8_t>& out, int32_t v){
+    PutVarint(out, (uint32_t(v) << 1) ^ uint32_t(v >> 31));
+}
+
+void PutU16(std::vector<uint8_t>& out, uint16_t v){
+    out.push_back(uint8_t(v));
+    out.push_back(uint8_t(v >> 8));
+}
+
+// reads stop at the end of the buffer, the first failed read leaves ok false for good
+struct Reader {
+    const uint8_t* at;
+    const uint8_t* end;
+    bool ok = true;
+
+    uint8_t byte(){
+        if(at >= end){ ok = false; return 0; }
+        return *at++;
+    }
+    uint16_t u16(){
+        uint16_t lo = byte();
+        return uint16_t(lo | (byte() << 8));
+    }
+    uint32_t varint(){
+        uint32_t v = 0;
+        for(int shift = 0; shift < 35; shift += 7){
+            uint8_t b = byte();
+            v |= uint32_t(b & 0x7f) << shift;
+            if(!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+    int32_t zigzag(){
+        uint32_t v = varint();
+        return int32_t(v >> 1) ^ -int32_t(v & 1);
+    }
+};
+
+uint16_t Quantize(float pixels){
+    return uint16_t(std::min(65535.0f, std::max(0.0f, pixels * kSnapshotUnitsPerPixel + 0.5f)));
+}
+
+uint8_t QuantizeScale(float scale){
+    return uint8_t(std::min(255.0f, std::max(1.0f, scale * 32 + 0.5f)));
+}
+
+}
+
+
+void CaptureSnapshot(const Aquarium& aquarium, const std::vector<std::shared_ptr<PlayerCreature>>& players,
+                     uint32_t tick, Snapshot& out){
+    out.tick = tick;
+    out.entities.clear();
+    for(const std::shared_ptr<Creature>& c : aquarium.getCreatures()){
+        const NPCreature& npc = static_cast<const NPCreature&>(*c);
+        SnapshotEntity e;
+        e.id = npc.getId();
+        e.type = uint8_t(npc.GetType());
+        e.flags = npc.isFlipped() ? kSnapshotFlipped : 0;
+        e.scale = QuantizeScale(npc.getBossScale());
+        e.x = Quantize(npc.getX());
+        e.y = Quantize(npc.getY());
+        out.entities.push_back(e);
+    }
+    for(size_t p = 0; p < players.size(); ++p){
+        const PlayerCreature& player = *players[p];
+        if(player.getLives() <= 0) continue;
+        SnapshotEntity e;
+        e.id = player.getId();
+        e.type = uint8_t(kSnapshotPlayerType + p);
+        e.flags = player.isFlipped() ? kSnapshotFlipped : 0;
+        e.scale = QuantizeScale(player.getModifiers().size);
+        e.x = Quantize(player.getX());
+        e.y = Quantize(player.getY());
+        out.entities.push_back(e);
+    }
+    // creatures are mostly in spawn order already, so this is close to a linear pass
+    std::sort(out.entities.begin(), out.entities.end(),
+        [](const SnapshotEntity& a, const SnapshotEntity& b){ return a.id < b.id; });
+}
+
+
+// format, tick, baseline tick (0 for none), then the ids that left and the entities that changed
+// ids are written as the gap from the previous one in the same list
+void EncodeSnapshot(const Snapshot& current, const Snapshot* baseline, std::vector<uint8_t>& out){
+    out.clear();
+    out.push_back(kFormat);
+    PutVarint(out, current.tick);
+    PutVarint(out, baseline ? baseline->tick : 0);
+
+    static const std::vector<SnapshotEntity> kNothing;
+    const std::vector<SnapshotEntity>& before = baseline ? baseline->entities : kNothing;
+    const std::vector<SnapshotEntity>& now = current.entities;
+
+    // a merge of the two id ordered lists, removals first since their count goes in front
+    std::vector<uint32_t> removed;
+    size_t i = 0, j = 0;
+    while(i < before.size()){
+        while(j < now.size() && now[j].id < before[i].id) ++j;
+        if(j >= now.size() || now[j].id != before[i].id) removed.push_back(before[i].id);
+        ++i;
+    }
+    PutVarint(out, removed.size());
+    uint32_t lastId = 0;
+    for(uint32_t id : removed){
+        PutVarint(out, id - lastId);
+        lastId = id;
+    }
+
+    // the changed count goes before the entities, its place is reserved and filled in after
+    size_t countAt = out.size();
+    out.insert(out.end(), 5, 0);
+    uint32_t changed = 0;
+    lastId = 0;
+    i = 0;
+    for(const SnapshotEntity& e : now){
+        while(i < before.size() && before[i].id < e.id) ++i;
+        const SnapshotEntity* old = i < before.size() && before[i].id == e.id ? &before[i] : nullptr;
+        uint8_t mask = 0;
+        if(old == nullptr){
+            mask = kNew;
+        } else {
+            if(e.x != old->x) mask |= kMovedX;
+            if(e.y != old->y) mask |= kMovedY;
+            if(e.type != old->type || e.flags != old->flags || e.scale != old->scale) mask |= kLooks;
+            if(mask == 0) continue;
+        }
+        ++changed;
+        PutVarint(out, e.id - lastId);
+        lastId = e.id;
+        out.push_back(mask);
+        if(mask & kNew){
+            out.push_back(e.type);
+            out.push_back(e.flags);
+            out.push_back(e.scale);
+            PutU16(out, e.x);
+            PutU16(out, e.y);
+            continue;
+        }
+        if(mask & kMovedX) PutZigzag(out, int32_t(e.x) - int32_t(old->x));
+        if(mask & kMovedY) PutZigzag(out, int32_t(e.y) - int32_t(old->y));
+        if(mask & kLooks){
+            out.push_back(e.type);
+            out.push_back(e.flags);
+            out.push_back(e.scale);
+        }
+    }
+    // a five byte varint whatever the count, padded with continuation bits
+    for(int b = 0; b < 5; ++b){
+        out[countAt + b] = uint8_t(((changed >> (7 * b)) & 0x7f) | (b < 4 ? 0x80 : 0));
+    }
+}
+
+bool ReadBaselineTick(const uint8_t* data, size_t size, uint32_t& baselineTick){
+    Reader in{data, data + size};
+    if(in.byte() != kFormat) return false;
+    in.varint();
+    baselineTick = in.varint();
+    return in.ok;
+}
+
+bool DecodeSnapshot(const uint8_t* data, size_t size, const Snapshot* baseline, Snapshot& out){
+    Reader in{data, data + size};
+    if(in.byte() != kFormat) return false;
+    out.tick = in.varint();
+    uint32_t baselineTick = in.varint();
+    if(baselineTick != 0 && (baseline == nullptr || baseline->tick != baselineTick)) return false;
+    static const std::vector<SnapshotEntity> kNothing;
+    const std::vector<SnapshotEntity>& before = baselineTick != 0 ? baseline->entities : kNothing;
+
+    std::vector<uint32_t> removed(std::min<uint32_t>(in.varint(), size));
+    uint32_t id = 0;
+    for(uint32_t& r : removed){
+        id += in.varint();
+        r = id;
+    }
+    uint32_t changed = in.varint();
+    if(!in.ok) return false;
+
+    // baseline entities that stayed, with the changes merged in as they come, all in id order
+    out.entities.clear();
+    size_t b = 0, r = 0;
+    id = 0;
+    auto keepUpTo = [&](uint32_t limit){
+        while(b < before.size() && before[b].id < limit){
+            while(r < removed.size() && removed[r] < before[b].id) ++r;
+            if(r >= removed.size() || removed[r] != before[b].id) out.entities.push_back(before[b]);
+            ++b;
+        }
+    };
+    for(uint32_t c = 0; c < changed && in.ok; ++c){
+        id += in.varint();
+        uint8_t mask = in.byte();
+        keepUpTo(id);
+        SnapshotEntity e;
+        if(mask & kNew){
+            e.id = id;
+            e.type = in.byte();
+            e.flags = in.byte();
+            e.scale = in.byte();
+            e.x = in.u16();
+            e.y = in.u16();
+        } else {
+            if(b >= before.size() || before[b].id != id) return false; // a change to something never sent
+            e = before[b++];
+            if(mask & kMovedX) e.x = uint16_t(int32_t(e.x) + in.zigzag());
+            if(mask & kMovedY) e.y = uint16_t(int32_t(e.y) + in.zigzag());
+            if(mask & kLooks){
+                e.type = in.byte();
+                e.flags = in.byte();
+                e.scale = in.byte();
+            }
+        }
+        out.entities.push_back(e);
+    }
+    keepUpTo(UINT32_MAX);
+    return in.ok;
+}
+
+
+void SnapshotHistory::Add(Snapshot snapshot){
+    if(!m_snapshots.empty() && snapshot.tick <= m_snapshots.back().tick) return;
+    m_snapshots.push_back(std::move(snapshot));
+    while(m_snapshots.size() > size_t(kKept)) m_snapshots.pop_front();
+}
+
+const Snapshot* SnapshotHistory::Find(uint32_t tick) const {
+    for(auto it = m_snapshots.rbegin(); it != m_snapshots.rend(); ++it){
+        if(it->tick == tick) return &*it;
+        if(it->tick < tick) break;
+    }
+    return nullptr;
+}
+
+void SnapshotHistory::Sample(float tick, std::vector<InterpolatedEntity>& out) const {
+    out.clear();
+    if(m_snapshots.empty()) return;
+    // the pair around tick, or the same snapshot twice past either end
+    size_t later = 0;
+    while(later < m_snapshots.size() && m_snapshots[later].tick < tick) ++later;
+    if(later == m_snapshots.size()) --later;
+    size_t earlier = later > 0 && m_snapshots[later].tick > tick ? later - 1 : later;
+    const Snapshot& a = m_snapshots[earlier];
+    const Snapshot& b = m_snapshots[later];
+    float t = b.tick > a.tick ? std::min(1.0f, std::max(0.0f, (tick - a.tick) / float(b.tick - a.tick))) : 1.0f;
+
+    const float toPixels = 1.0f / kSnapshotUnitsPerPixel;
+    size_t i = 0;
+    for(const SnapshotEntity& e : b.entities){
+        while(i < a.entities.size() && a.entities[i].id < e.id) ++i;
+        InterpolatedEntity drawn{e.id, e.type, (e.flags & kSnapshotFlipped) != 0, e.x * toPixels, e.y * toPixels, e.scale / 32.0f};
+        if(i < a.entities.size() && a.entities[i].id == e.id){
+            const SnapshotEntity& from = a.entities[i];
+            drawn.x = (from.x + (float(e.x) - from.x) * t) * toPixels;
+            drawn.y = (from.y + (float(e.y) - from.y) * t) * toPixels;
+            drawn.scale = (from.scale + (float(e.scale) - from.scale) * t) / 32.0f;
+            if(t < 0.5f) drawn.flipped = (from.flags & kSnapshotFlipped) != 0;
+        }
+        out.push_back(drawn);
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+class Aquarium;
+class PlayerCreature;
+
+
+// positions go over the wire in quarter pixels, a 16 bit coordinate covers a tank up to 16k pixels a side
+const int kSnapshotUnitsPerPixel = 4;
+// creature types are AquariumCreatureType, players are this plus their index
+const uint8_t kSnapshotPlayerType = 64;
+const uint8_t kSnapshotFlipped = 1;
+
+// one creature or player the way a render client sees it
+struct SnapshotEntity {
+    uint32_t id = 0;
+    uint8_t type = 0;
+    uint8_t flags = 0;
+    uint8_t scale = 32; // sprite scale in 32nds, bosses and the size effect grow it
+    uint16_t x = 0;
+    uint16_t y = 0;
+
+    bool operator==(const SnapshotEntity& o) const {
+        return id == o.id && type == o.type && flags == o.flags && scale == o.scale && x == o.x && y == o.y;
+    }
+};
+
+// everything in the tank at one simulation tick, sorted by id so two of them merge in one pass
+struct Snapshot {
+    uint32_t tick = 0;
+    std::vector<SnapshotEntity> entities;
+};
+
+void CaptureSnapshot(const Aquarium& aquarium, const std::vector<std::shared_ptr<PlayerCreature>>& players,
+                     uint32_t tick, Snapshot& out);
+
+// delta coding against a snapshot the receiver already has, null baseline sends everything
+// only what changed goes out: ids that left, ids that are new in full, and for the rest the fields
+// that moved as zigzag varint differences, a fish drifting a pixel costs about four bytes
+void EncodeSnapshot(const Snapshot& current, const Snapshot* baseline, std::vector<uint8_t>& out);
+// the baseline tick is in the data, ReadBaselineTick() says which one to pass back in
+bool ReadBaselineTick(const uint8_t* data, size_t size, uint32_t& baselineTick);
+bool DecodeSnapshot(const uint8_t* data, size_t size, const Snapshot* baseline, Snapshot& out);
+
+
+// where an entity is drawn, between two snapshots
+struct InterpolatedEntity {
+    uint32_t id;
+    uint8_t type;
+    bool flipped;
+    float x;
+    float y;
+    float scale;
+};
+
+// the last few snapshots a client got, sampled a little in the past so there is always
+// a snapshot on either side of the time being drawn
+class SnapshotHistory {
+    public:
+        static const int kKept = 64;
+
+        // older ticks than the newest one are dropped, a tcp stream never reorders them anyway
+        void Add(Snapshot snapshot);
+        const Snapshot* Find(uint32_t tick) const;
+        const Snapshot* Latest() const { return m_snapshots.empty() ? nullptr : &m_snapshots.back(); }
+        void Clear() { m_snapshots.clear(); }
+
+        // entities at a fractional tick, held at the ends when the tick is outside what is kept
+        // something only in the later snapshot pops in, something only in the earlier one is gone
+        void Sample(float tick, std::vector<InterpolatedEntity>& out) const;
+
+    private:
+        std::deque<Snapshot> m_snapshots;
+};
@@ -0,0 +1,97 @@
+#include "SpawnPlacement.h"
+#include "Core.h"
+
+
+void SpawnPlacer::Begin(const ofRectangle& area, const SpatialGrid* existing, float cellSize){
+    m_area = area;
+    m_existing = existing;
+    m_safeZones.clear();
+    m_x.clear();
+    m_y.clear();
+    m_r.clear();
+    m_next.clear();
+    m_maxRadius = 0;
+    m_rejected = 0;
+    m_fallbacks = 0;
+
+    // the batch grid covers the spawn area only, so its size does not depend on the tank
+    m_cellSize = std::max(cellSize, 1.0f);
+    m_cols = std::max(1, int(area.width / m_cellSize) + 1);
+    m_rows = std::max(1, int(area.height / m_cellSize) + 1);
+    m_cellHead.assign(m_cols * m_rows, -1);
+}
+
+int SpawnPlacer::cellX(float x) const {
+    return std::min(std::max(int((x - m_area.x) / m_cellSize), 0), m_cols - 1);
+}
+
+int SpawnPlacer::cellY(float y) const {
+    return std::min(std::max(int((y - m_area.y) / m_cellSize), 0), m_rows - 1);
+}
+
+bool SpawnPlacer::inSafeZone(float x, float y, float radius) const {
+    for(const SpawnSafeZone& zone : m_safeZones){
+        float dx = x - zone.x;
+        float dy = y - zone.y;
+        float r = radius + zone.radius;
+        if(dx * dx + dy * dy < r * r) return true;
+    }
+    return false;
+}
+
+bool SpawnPlacer::overlapsBatch(float x, float y, float radius) const {
+    if(m_x.empty()) return false;
+    float reach = radius + m_maxRadius;
+    int x0 = cellX(x - reach), x1 = cellX(x + reach);
+    int y0 = cellY(y - reach), y1 = cellY(y + reach);
+    for(int cy = y0; cy <= y1; ++cy){
+        for(int cx = x0; cx <= x1; ++cx){
+            for(int i = m_cellHead[cy * m_cols + cx]; i >= 0; i = m_next[i]){
+                float dx = m_x[i] - x;
+                float dy = m_y[i] - y;
+                float r = radius + m_r[i];
+                if(dx * dx + dy * dy < r * r) return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool SpawnPlacer::Place(float radius, float gap, float& x, float& y){
+    int w = std::max(1, int(m_area.width));
+    int h = std::max(1, int(m_area.height));
+    float clearance = radius + gap;
+    bool clear = false;
+    bool haveFallback = false;
+    for(int attempt = 0; attempt < m_maxTries; ++attempt){
+        float cx = m_area.x + CreatureRandom() % w;
+        float cy = m_area.y + CreatureRandom() % h;
+        // the safe zone is the rule that matters most, a fish touching another one is only a bounce
+        if(inSafeZone(cx, cy, radius)){
+            if(!haveFallback){ x = cx; y = cy; }
+            ++m_rejected;
+            continue;
+        }
+        x = cx;
+        y = cy;
+        haveFallback = true;
+        if((m_existing && m_existing->Overlaps(cx, cy, clearance)) || overlapsBatch(cx, cy, clearance)){
+            ++m_rejected;
+            continue;
+        }
+        clear = true;
+        break;
+    }
+    if(!clear){
+        ++m_fallbacks;
+    }
+
+    int cell = cellY(y) * m_cols + cellX(x);
+    m_next.push_back(m_cellHead[cell]);
+    m_cellHead[cell] = m_x.size();
+    m_x.push_back(x);
+    m_y.push_back(y);
+    m_r.push_back(radius);
+    m_maxRadius = std::max(m_maxRadius, radius);
+    return clear;
+}
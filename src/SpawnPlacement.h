@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include "ofMain.h"
+#include "Broadphase.h"
+
+
+// a circle new creatures must not appear in, usually around a player
+struct SpawnSafeZone {
+    float x = 0;
+    float y = 0;
+    float radius = 0;
+};
+
+// picks spawn positions that do not overlap anything already in the tank, anything placed
+// earlier in the same batch, or a safe zone
+// candidates are drawn at random and rejected against the aquarium's spatial index plus a small
+// grid of this batch's placements, a spawn gives up after a fixed number of tries so a full
+// tank still costs a bounded amount of work per creature
+class SpawnPlacer {
+    public:
+        // existing may be null for an empty tank, it has to outlive the batch
+        void Begin(const ofRectangle& area, const SpatialGrid* existing, float cellSize);
+        void AddSafeZone(const SpawnSafeZone& zone) { m_safeZones.push_back(zone); }
+        void SetMaxTries(int tries) { m_maxTries = std::max(1, tries); }
+
+        // writes the chosen center to x, y and returns true when it is clear of everything
+        // when every try was rejected the last candidate outside the safe zones is used, or the
+        // last one at all, and false is returned so the caller can count it
+        bool Place(float radius, float gap, float& x, float& y);
+
+        int GetPlacedCount() const { return m_x.size(); }
+        long GetRejectedCount() const { return m_rejected; }
+        int GetFallbackCount() const { return m_fallbacks; }
+
+    private:
+        bool inSafeZone(float x, float y, float radius) const;
+        bool overlapsBatch(float x, float y, float radius) const;
+        int cellX(float x) const;
+        int cellY(float y) const;
+
+        ofRectangle m_area;
+        const SpatialGrid* m_existing = nullptr;
+        std::vector<SpawnSafeZone> m_safeZones;
+        int m_maxTries = 12;
+
+        // this batch's placements, chained per cell so inserting is O(1)
+        float m_cellSize = 1;
+        int m_cols = 0;
+        int m_rows = 0;
+        float m_maxRadius = 0;
+        std::vector<int> m_cellHead;
+        std::vector<int> m_next;
+        std::vector<float> m_x;
+        std::vector<float> m_y;
+        std::vector<float> m_r;
+
+        long m_rejected = 0;
+        int m_fallbacks = 0;
+};
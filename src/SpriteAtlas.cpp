@@ -0,0 +1,149 @@
+#include "SpriteAtlas.h"
+#include <algorithm>
+#include <cmath>
+#include "MemoryAccounting.h"
+
+
+namespace {
+
+const int kAtlasWidth = 1024;
+const int kPadding = 2;   // keeps filtering from bleeding one frame into the next
+const int kFinStrip = 2;  // columns of the image moved together when drawing fins
+
+int MarginFor(const SpriteSource& source){
+    if(source.animation.motion == SpriteMotion::STILL) return 0;
+    return int(std::ceil(0.1f * std::max(source.width, source.height)));
+}
+
+}
+
+
+SpriteAtlas::~SpriteAtlas(){
+    // an atlas that was never laid out was never counted, freeing it would unbalance the ledger
+    if(m_trackedBytes > 0){
+        MemoryLedger::Freed(MemorySubsystem::SPRITES, m_trackedBytes);
+    }
+}
+
+void SpriteAtlas::Layout(const std::vector<SpriteSource>& sources){
+    m_sprites.clear();
+    m_cells.clear();
+    // shelves, frames go left to right and a frame that does not fit starts a new row
+    int x = kPadding;
+    int y = kPadding;
+    int shelfHeight = 0;
+    for(const SpriteSource& source : sources){
+        Placed placed;
+        placed.firstFrame = m_cells.size();
+        placed.frames = std::max<int>(1, source.animation.frames);
+        placed.margin = MarginFor(source);
+        int cellW = source.width + 2 * placed.margin;
+        int cellH = source.height + 2 * placed.margin;
+        for(int f = 0; f < placed.frames; ++f){
+            if(x + cellW + kPadding > kAtlasWidth && x > kPadding){
+                x = kPadding;
+                y += shelfHeight + kPadding;
+                shelfHeight = 0;
+            }
+            m_cells.push_back(ofRectangle(x, y, cellW, cellH));
+            x += cellW + kPadding;
+            shelfHeight = std::max(shelfHeight, cellH);
+        }
+        m_sprites.push_back(placed);
+    }
+    m_width = kAtlasWidth;
+    m_height = y + shelfHeight + kPadding;
+}
+
+void SpriteAtlas::Build(const std::vector<SpriteSource>& sources){
+    this->Layout(sources);
+    m_fbo.allocate(m_width, m_height, GL_RGBA);
+    m_fbo.begin();
+    ofClear(0, 0, 0, 0);
+    ofSetColor(ofColor::white);
+    for(size_t s = 0; s < sources.size(); ++s){
+        if(sources[s].image == nullptr) continue;
+        for(int f = 0; f < m_sprites[s].frames; ++f){
+            this->renderFrame(sources[s], f, m_cells[m_sprites[s].firstFrame + f], m_sprites[s].margin);
+        }
+    }
+    m_fbo.end();
+
+    m_texCoords.clear();
+    const ofTexture& texture = m_fbo.getTexture();
+    for(const ofRectangle& cell : m_cells){
+        m_texCoords.push_back(texture.getCoordFromPoint(cell.x, cell.y));
+        m_texCoords.push_back(texture.getCoordFromPoint(cell.x + cell.width, cell.y + cell.height));
+    }
+    if(m_trackedBytes > 0){
+        MemoryLedger::Freed(MemorySubsystem::SPRITES, m_trackedBytes);
+    }
+    m_trackedBytes = this->GetBytes();
+    MemoryLedger::Allocated(MemorySubsystem::SPRITES, m_trackedBytes);
+    ofLogNotice() << "sprite atlas " << m_width << "x" << m_height << " with " << m_cells.size() << " frames" << std::endl;
+}
+
+void SpriteAtlas::renderFrame(const SpriteSource& source, int frame, const ofRectangle& cell, int margin){
+    float w = source.width;
+    float h = source.height;
+    float left = cell.x + margin;
+    float top = cell.y + margin;
+    float cycle = TWO_PI * frame / std::max<int>(1, source.animation.frames);
+    switch(source.animation.motion){
+        case SpriteMotion::FINS:
+            // unflipped sprites face right, so the tail is on the left and swings the most
+            for(int c = 0; c < source.width; c += kFinStrip){
+                float along = c / w;
+                float swing = (1 - along) * (1 - along);
+                float dy = 0.6f * margin * swing * std::sin(cycle + along * PI * 1.5f);
+                int strip = std::min(kFinStrip, source.width - c);
+                source.image->drawSubsection(left + c, top + dy, strip, h, c, 0, strip, h);
+            }
+            break;
+        case SpriteMotion::PULSE:
+            {
+                float squash = 0.08f * std::sin(cycle);
+                float drawW = w * (1 + squash);
+                float drawH = h * (1 - squash);
+                source.image->draw(left + (w - drawW) / 2, top + (h - drawH) / 2, drawW, drawH);
+            }
+            break;
+        case SpriteMotion::STILL:
+        default:
+            source.image->draw(left, top, w, h);
+            break;
+    }
+}
+
+void SpriteAtlas::Begin(){
+    m_mesh.clear();
+    m_mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+}
+
+void SpriteAtlas::Add(int sprite, int frame, float x, float y, bool flipped, float scale){
+    const Placed& placed = m_sprites[sprite];
+    int cellIndex = placed.firstFrame + frame % placed.frames;
+    const ofRectangle& cell = m_cells[cellIndex];
+    glm::vec2 uv0 = m_texCoords[2 * cellIndex];
+    glm::vec2 uv1 = m_texCoords[2 * cellIndex + 1];
+    if(flipped) std::swap(uv0.x, uv1.x);
+
+    float x0 = x - placed.margin * scale;
+    float y0 = y - placed.margin * scale;
+    float x1 = x0 + cell.width * scale;
+    float y1 = y0 + cell.height * scale;
+    m_mesh.addVertex(glm::vec3(x0, y0, 0)); m_mesh.addTexCoord(glm::vec2(uv0.x, uv0.y));
+    m_mesh.addVertex(glm::vec3(x1, y0, 0)); m_mesh.addTexCoord(glm::vec2(uv1.x, uv0.y));
+    m_mesh.addVertex(glm::vec3(x1, y1, 0)); m_mesh.addTexCoord(glm::vec2(uv1.x, uv1.y));
+    m_mesh.addVertex(glm::vec3(x0, y0, 0)); m_mesh.addTexCoord(glm::vec2(uv0.x, uv0.y));
+    m_mesh.addVertex(glm::vec3(x1, y1, 0)); m_mesh.addTexCoord(glm::vec2(uv1.x, uv1.y));
+    m_mesh.addVertex(glm::vec3(x0, y1, 0)); m_mesh.addTexCoord(glm::vec2(uv0.x, uv1.y));
+}
+
+void SpriteAtlas::Draw() const {
+    if(m_mesh.getNumVertices() == 0) return;
+    ofSetColor(ofColor::white);
+    m_fbo.getTexture().bind();
+    m_mesh.draw();
+    m_fbo.getTexture().unbind();
+}
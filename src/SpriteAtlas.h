@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ofMain.h"
+
+
+// how a sprite moves, its frames are drawn from the one still image it is loaded from
+enum class SpriteMotion : uint8_t {
+    STILL,
+    FINS,  // a wave running back along the body that grows toward the tail
+    PULSE  // the bell squashing and stretching, wider as it gets shorter
+};
+
+struct SpriteAnimation {
+    SpriteMotion motion = SpriteMotion::STILL;
+    uint8_t frames = 1;
+    uint8_t ticksPerFrame = 1;
+};
+
+// one sprite to pack, the image can be null when only the layout is wanted
+struct SpriteSource {
+    const ofImage* image = nullptr;
+    int width = 0;
+    int height = 0;
+    SpriteAnimation animation;
+};
+
+// every frame of every sprite in one texture, so a whole tank draws as a single textured mesh
+// creatures only carry a frame index, a timer and which way they face, nothing per instance lives here
+// frames get a margin around the image so the fins and the pulse have room to move into
+class SpriteAtlas {
+    public:
+        SpriteAtlas() = default;
+        SpriteAtlas(const SpriteAtlas&) = delete;
+        SpriteAtlas& operator=(const SpriteAtlas&) = delete;
+        ~SpriteAtlas();
+
+        // sprite ids are the indices into sources
+        // Layout() only works out where the frames go, Build() also renders them
+        void Layout(const std::vector<SpriteSource>& sources);
+        void Build(const std::vector<SpriteSource>& sources);
+        bool IsBuilt() const { return m_fbo.isAllocated(); }
+        int GetWidth() const { return m_width; }
+        int GetHeight() const { return m_height; }
+        int64_t GetBytes() const { return int64_t(m_width) * m_height * 4; }
+
+        // quads are collected between Begin() and Draw(), x and y are where the still image's corner would be
+        // scale grows the sprite away from that corner
+        void Begin();
+        void Add(int sprite, int frame, float x, float y, bool flipped, float scale = 1);
+        void Draw() const;
+
+    private:
+        struct Placed {
+            int firstFrame = 0;
+            int frames = 1;
+            int margin = 0; // around the image on every side of a frame
+        };
+        void renderFrame(const SpriteSource& source, int frame, const ofRectangle& cell, int margin);
+
+        std::vector<Placed> m_sprites;
+        std::vector<ofRectangle> m_cells;   // every frame's place in the atlas, in pixels
+        std::vector<glm::vec2> m_texCoords; // top left and bottom right of every cell, what the texture wants
+        int m_width = 0;
+        int m_height = 0;
+        int64_t m_trackedBytes = 0;
+        ofFbo m_fbo;
+        ofMesh m_mesh;
+};
@@ -0,0 +1,143 @@
+#include "TimedEffects.h"
+#include <algorithm>
+
+
+const char* EffectKindToString(EffectKind kind){
+    switch(kind){
+        case EffectKind::SPEED: return "SPEED";
+        case EffectKind::SIZE: return "SIZE";
+        case EffectKind::INVULNERABLE: return "INVULNERABLE";
+        case EffectKind::MAGNET: return "MAGNET";
+        case EffectKind::SCORE: return "SCORE";
+        default: return "UNKNOWN";
+    }
+}
+
+
+void EffectSystem::Apply(const Creature& target, const EffectGrant& grant){
+    if(grant.kind >= EffectKind::COUNT) return;
+    int set;
+    auto found = m_owners.find(&target);
+    if(found != m_owners.end()){
+        set = found->second;
+    } else {
+        if(!m_freeSets.empty()){
+            set = m_freeSets.back();
+            m_freeSets.pop_back();
+        } else {
+            set = m_sets.size();
+            m_sets.emplace_back();
+        }
+        m_sets[set].owner = &target;
+        m_owners.emplace(&target, set);
+    }
+
+    EffectSet& s = m_sets[set];
+    uint32_t expires = m_tick + std::max<uint32_t>(1, grant.ticks);
+    Effect* effect = nullptr;
+    for(int i = 0; i < s.count; ++i){
+        if(s.effects[i].kind == grant.kind) effect = &s.effects[i];
+    }
+    if(effect == nullptr){
+        effect = &s.effects[s.count++];
+        *effect = Effect{grant.kind, grant.magnitude, 0, 0};
+        ++m_active;
+    } else {
+        effect->magnitude = std::max(effect->magnitude, grant.magnitude);
+    }
+    if(expires > effect->expires){
+        // the old timer stays in the wheel and is dropped when it finds its id gone
+        effect->expires = expires;
+        effect->id = m_nextId++;
+        m_wheel[expires % kWheelSlots].push_back(Timer{expires, effect->id, set});
+    }
+    recompute(s);
+}
+
+void EffectSystem::Clear(const Creature& target){
+    auto found = m_owners.find(&target);
+    if(found == m_owners.end()) return;
+    m_active -= m_sets[found->second].count;
+    this->release(found->second);
+}
+
+void EffectSystem::ClearAll(){
+    for(auto& slot : m_wheel) slot.clear();
+    m_sets.clear();
+    m_freeSets.clear();
+    m_owners.clear();
+    m_active = 0;
+}
+
+void EffectSystem::Tick(){
+    ++m_tick;
+    m_lastExpired = 0;
+    std::vector<Timer>& due = m_wheel[m_tick % kWheelSlots];
+    m_lastVisited = due.size();
+    // swap and pop, the order within a slot does not matter, expiring never schedules anything
+    for(size_t i = 0; i < due.size(); ){
+        if(due[i].expires != m_tick){
+            ++i; // a later revolution
+            continue;
+        }
+        this->expire(due[i].set, due[i].id);
+        due[i] = due.back();
+        due.pop_back();
+    }
+}
+
+const EffectModifiers& EffectSystem::Get(const Creature& target) const {
+    static const EffectModifiers kNone;
+    auto found = m_owners.find(&target);
+    return found == m_owners.end() ? kNone : m_sets[found->second].modifiers;
+}
+
+uint32_t EffectSystem::GetRemainingTicks(const Creature& target, EffectKind kind) const {
+    auto found = m_owners.find(&target);
+    if(found == m_owners.end()) return 0;
+    const EffectSet& s = m_sets[found->second];
+    for(int i = 0; i < s.count; ++i){
+        if(s.effects[i].kind == kind) return s.effects[i].expires - m_tick;
+    }
+    return 0;
+}
+
+void EffectSystem::expire(int set, uint32_t id){
+    EffectSet& s = m_sets[set];
+    for(int i = 0; i < s.count; ++i){
+        if(s.effects[i].id != id) continue;
+        s.effects[i] = s.effects[--s.count];
+        --m_active;
+        ++m_lastExpired;
+        if(s.count == 0){
+            this->release(set);
+        } else {
+            recompute(s);
+        }
+        return;
+    }
+}
+
+void EffectSystem::release(int set){
+    EffectSet& s = m_sets[set];
+    m_owners.erase(s.owner);
+    s = EffectSet();
+    m_freeSets.push_back(set);
+}
+
+void EffectSystem::recompute(EffectSet& s){
+    EffectModifiers m;
+    for(int i = 0; i < s.count; ++i){
+        const Effect& e = s.effects[i];
+        m.active |= uint8_t(1u << int(e.kind));
+        switch(e.kind){
+            case EffectKind::SPEED: m.speed = e.magnitude; break;
+            case EffectKind::SIZE: m.size = e.magnitude; break;
+            case EffectKind::INVULNERABLE: m.invulnerable = true; break;
+            case EffectKind::MAGNET: m.magnetRadius = e.magnitude; break;
+            case EffectKind::SCORE: m.score = e.magnitude; break;
+            default: break;
+        }
+    }
+    s.modifiers = m;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Creature;
+
+
+enum class EffectKind : uint8_t {
+    SPEED,         // magnitude multiplies the speed
+    SIZE,          // magnitude multiplies the collision radius and the sprite
+    INVULNERABLE,  // nothing costs a life while it lasts, magnitude is unused
+    MAGNET,        // edible creatures within magnitude pixels are pulled in
+    SCORE,         // magnitude multiplies the points scored
+    COUNT
+};
+
+const char* EffectKindToString(EffectKind kind);
+
+// what a power up hands out
+struct EffectGrant {
+    EffectKind kind = EffectKind::SPEED;
+    float magnitude = 1;
+    uint32_t ticks = 0;
+};
+
+// what the effects on one creature add up to, worked out when one starts or runs out
+// so whoever reads it every tick only reads a few floats
+struct EffectModifiers {
+    float speed = 1;
+    float size = 1;
+    float score = 1;
+    float magnetRadius = 0;
+    bool invulnerable = false;
+    uint8_t active = 0; // bit per EffectKind
+
+    bool has(EffectKind kind) const { return active & (1u << int(kind)); }
+};
+
+// timed effects on creatures, each creature with any gets one small packed array, one entry per kind
+// expiry goes through a timer wheel, a tick only looks at the slot that is due instead of at every
+// effect's countdown, so a tick with hundreds of effects running costs about what runs out on it
+// applying a kind that is already running keeps the stronger magnitude and the later end
+class EffectSystem {
+    public:
+        // one revolution is about 8.5 seconds at 120 ticks a second, longer effects are passed over once per turn
+        static const int kWheelSlots = 1024;
+
+        EffectSystem() = default;
+        EffectSystem(const EffectSystem&) = delete;
+        EffectSystem& operator=(const EffectSystem&) = delete;
+
+        // the creature is only used as a key, Clear() it before it goes away
+        void Apply(const Creature& target, const EffectGrant& grant);
+        void Clear(const Creature& target);
+        void ClearAll();
+        void Tick();
+
+        // the defaults for a creature without effects
+        const EffectModifiers& Get(const Creature& target) const;
+        uint32_t GetRemainingTicks(const Creature& target, EffectKind kind) const;
+        uint32_t GetTick() const { return m_tick; }
+        int GetActiveCount() const { return m_active; }
+        int GetAffectedCount() const { return m_owners.size(); }
+        // effects that ran out on the latest Tick(), and wheel entries it looked at to find them
+        int GetLastExpiredCount() const { return m_lastExpired; }
+        int GetLastVisitedCount() const { return m_lastVisited; }
+
+    private:
+        struct Effect {
+            EffectKind kind;
+            float magnitude;
+            uint32_t expires;
+            uint32_t id; // never reused, so a timer left behind by a refresh or a clear finds nothing
+        };
+        struct EffectSet {
+            std::array<Effect, int(EffectKind::COUNT)> effects;
+            uint8_t count = 0;
+            EffectModifiers modifiers;
+            const Creature* owner = nullptr;
+        };
+        struct Timer {
+            uint32_t expires;
+            uint32_t id;
+            int set;
+        };
+
+        void expire(int set, uint32_t id);
+        void release(int set);
+        static void recompute(EffectSet& set);
+
+        std::vector<EffectSet> m_sets;
+        std::vector<int> m_freeSets;
+        std::unordered_map<const Creature*, int> m_owners;
+        std::array<std::vector<Timer>, kWheelSlots> m_wheel;
+        uint32_t m_tick = 0;
+        uint32_t m_nextId = 1;
+        int m_active = 0;
+        int m_lastExpired = 0;
+        int m_lastVisited = 0;
+};
@@ -1,8 +1,115 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "Benchmark.h"
+#include "BatchRunner.h"
+#include "RemoteInput.h"
+#include "SnapshotNet.h"
+#include "SimulationFuzz.h"
+#include "MotionTables.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
+
+	// tweakable swim patterns, the built in ones stay if the file is missing
+	// read before anything else so the headless tools move fish the way the game does
+	MotionTables::LoadFile(ofToDataPath("motion-patterns.txt"));
+
+	// headless tools, these never open a window
+	std::string mode = argc > 1 ? argv[1] : "";
+	if(mode == "--bench-broadphase"){
+		return RunBroadphaseBenchmark();
+	}
+	if(mode == "--bench-schooling"){
+		return RunSchoolingBenchmark();
+	}
+	if(mode == "--bench-spawn"){
+		return RunSpawnBenchmark();
+	}
+	if(mode == "--bench-contacts"){
+		return RunContactBenchmark();
+	}
+	if(mode == "--bench-ecosystem"){
+		return RunEcosystemBenchmark();
+	}
+	if(mode == "--bench-scripts"){
+		return RunScriptBenchmark();
+	}
+	if(mode == "--bench-effects"){
+		return RunEffectBenchmark();
+	}
+	if(mode == "--bench-players"){
+		return RunPlayerCollisionBenchmark();
+	}
+	if(mode == "--bench-snapshots"){
+		return RunSnapshotBenchmark();
+	}
+	if(mode == "--input-host"){
+		// --input-host port [players] [ticks], a game only --input-client processes steer
+		if(argc < 3){
+			ofLogError() << "usage: --input-host port [players] [ticks]";
+			return 1;
+		}
+		return RunInputHost(std::atoi(argv[2]), argc > 3 ? std::atoi(argv[3]) : 2, argc > 4 ? std::atoi(argv[4]) : 1800);
+	}
+	if(mode == "--input-client"){
+		// --input-client port player [seconds]
+		if(argc < 4){
+			ofLogError() << "usage: --input-client port player [seconds]";
+			return 1;
+		}
+		return RunInputClient(std::atoi(argv[2]), std::atoi(argv[3]), argc > 4 ? std::atoi(argv[4]) : 30);
+	}
+	if(mode == "--serve"){
+		// --serve port [players] [ticks], the game for --watch and --connect clients
+		if(argc < 3){
+			ofLogError() << "usage: --serve port [players] [ticks]";
+			return 1;
+		}
+		return RunSnapshotServer(std::atoi(argv[2]), argc > 3 ? std::atoi(argv[3]) : 2, argc > 4 ? std::atoi(argv[4]) : 1800);
+	}
+	if(mode == "--watch"){
+		// --watch port [seconds]
+		if(argc < 3){
+			ofLogError() << "usage: --watch port [seconds]";
+			return 1;
+		}
+		return RunSnapshotWatcher(std::atoi(argv[2]), argc > 3 ? std::atoi(argv[3]) : 30);
+	}
+	if(mode == "--memory-report"){
+		// --memory-report [creatures]
+		return RunMemoryReport(argc > 2 ? std::atoi(argv[2]) : 1000);
+	}
+	if(mode == "--analyze-frames"){
+		// --analyze-frames frames.csv [target fps]
+		if(argc < 3){
+			ofLogError() << "usage: --analyze-frames frames.csv [target fps]";
+			return 1;
+		}
+		return AnalyzeFrameLog(argv[2], argc > 3 ? std::atof(argv[3]) : 60.0f);
+	}
+	if(mode == "--batch"){
+		// --batch [sessions] [ticks per session] [random|seek] [results.csv]
+		BatchConfig config;
+		if(argc > 2) config.sessions = std::atoi(argv[2]);
+		if(argc > 3) config.ticksPerSession = std::atoi(argv[3]);
+		if(argc > 4 && !BatchPolicyFromString(argv[4], config.policy)){
+			ofLogError() << "unknown policy " << argv[4] << ", use random or seek";
+			return 1;
+		}
+		if(argc > 5) config.csvPath = argv[5];
+		return RunBatch(config);
+	}
+	if(mode == "--check-regions"){
+		return RunRegionRoundTripCheck();
+	}
+	if(mode == "--fuzz"){
+		// --fuzz [sequences] [steps per sequence] [seed]
+		FuzzConfig config;
+		if(argc > 2) config.sequences = std::atoi(argv[2]);
+		if(argc > 3) config.steps = std::atoi(argv[3]);
+		if(argc > 4) config.baseSeed = std::strtoul(argv[4], nullptr, 10);
+		return RunSimulationFuzz(config);
+	}
 
 	//Use ofGLFWWindowSettings for more options like multi-monitor fullscreen
 	ofGLWindowSettings settings;
@@ -11,7 +118,35 @@ int main( ){
 
 	auto window = ofCreateWindow(settings);
 
-	ofRunApp(window, std::make_shared<ofApp>());
+	// --record file saves the keys of this session, --replay file plays a saved one back
+	// --metrics file keeps a Prometheus text file of live stats up to date
+	// --frames file records frame timings and saves them on exit for --analyze-frames
+	// --players n puts n players in the tank, the first three share the keyboard
+	// --input-port port lets --input-client processes steer players from 127.0.0.1
+	// --connect port draws the game a --serve process runs instead of a local one
+	auto app = std::make_shared<ofApp>();
+	for(int i = 1; i + 1 < argc; i += 2){
+		std::string option = argv[i];
+		if(option == "--record"){
+			app->inputRecordPath = argv[i + 1];
+		} else if(option == "--replay"){
+			app->inputReplayPath = argv[i + 1];
+		} else if(option == "--metrics"){
+			app->metricsPath = argv[i + 1];
+		} else if(option == "--frames"){
+			app->framesPath = argv[i + 1];
+		} else if(option == "--players"){
+			app->playerCount = std::max(1, std::atoi(argv[i + 1]));
+		} else if(option == "--input-port"){
+			app->inputPort = std::atoi(argv[i + 1]);
+		} else if(option == "--connect"){
+			app->connectPort = std::atoi(argv[i + 1]);
+		} else {
+			ofLogError() << "unknown option " << option;
+		}
+	}
+
+	ofRunApp(window, app);
 	ofRunMainLoop();
 
 }
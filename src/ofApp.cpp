@@ -1,12 +1,13 @@
 #include "ofApp.h"
+#include <chrono>
+#include <sstream>
 
 //--------------------------------------------------------------
 void ofApp::setup(){
 
     ofSetFrameRate(60);
     ofSetBackgroundColor(ofColor::blue);
-    backgroundImage.load("background.png");
-    backgroundImage.resize(ofGetWindowWidth(), ofGetWindowHeight());
+    backgroundImage.load("background.png"); // stretched to the window when drawn, never resampled
 
 
     std::shared_ptr<Aquarium> myAquarium;
@@ -19,7 +20,7 @@ void ofApp::setup(){
     // first we make the intro scene 
     gameManager->AddScene(std::make_shared<GameIntroScene>(
         GameSceneKindToString(GameSceneKind::GAME_INTRO),
-        std::make_shared<GameSprite>("title.png", ofGetWindowWidth(), ofGetWindowHeight())
+        MakeTracked<MemorySubsystem::SPRITES, GameSprite>("title.png", ofGetWindowWidth(), ofGetWindowHeight())
     ));
 
     // load background music
@@ -36,26 +37,63 @@ void ofApp::setup(){
     bounceSound.setMultiPlay(true);
     munchSound.setMultiPlay(true);
 
+    // the sounds are decoded whole when loaded, the file size is a fair guess at what that costs
+    for(const char* file : {"underwater_theme.wav", "boing-2-44164.wav", "munch-sound-effect.wav"}){
+        MemoryLedger::Allocated(MemorySubsystem::AUDIO, ofFile(ofToDataPath(file)).getSize());
+    }
+
     //AquariumSpriteManager
     spriteManager = std::make_shared<AquariumSpriteManager>();
 
     // Lets setup the aquarium
-    myAquarium = std::make_shared<Aquarium>(ofGetWindowWidth(), ofGetWindowHeight(), spriteManager);
-    player = std::make_shared<PlayerCreature>(ofGetWindowWidth()/2 - 50, ofGetWindowHeight()/2 - 50, DEFAULT_SPEED, this->spriteManager->GetSprite(AquariumCreatureType::NPCreature));
+    // the tank is bigger than the view, the camera follows the player around it
+    // its size is in world units, so resizing the window never touches it
+    int worldWidth = VIEW_WIDTH * WORLD_SCALE;
+    int worldHeight = VIEW_HEIGHT * WORLD_SCALE;
+    myAquarium = std::make_shared<Aquarium>(worldWidth, worldHeight, spriteManager);
+    player = MakeTracked<MemorySubsystem::CREATURES, PlayerCreature>(worldWidth/2 - 50, worldHeight/2 - 50, DEFAULT_SPEED, this->spriteManager->GetSprite(AquariumCreatureType::NPCreature));
     player->setDirection(0, 0); // Initially stationary
-    player->setBounds(ofGetWindowWidth() - 20, ofGetWindowHeight() - 20);
 
 
-    myAquarium->addAquariumLevel(std::make_shared<Level_0>(0, 10));
-    myAquarium->addAquariumLevel(std::make_shared<Level_1>(1, 15));
-    myAquarium->addAquariumLevel(std::make_shared<Level_2>(2, 20));
-    myAquarium->addAquariumLevel(std::make_shared<Level_3>(3, 28));
-    myAquarium->Repopulate(); // initial population
+    // regions a couple of screens away from the player are kept on disk
+    myAquarium->enableRegionStreaming(ofToDataPath("regions"), 512, 1);
+
+    AddDefaultAquariumLevels(myAquarium);
+    myAquarium->StreamRegions(worldWidth/2, worldHeight/2); // spawn around the player from the start
 
     // now that we are mostly set, lets pass the player and the aquarium downstream
-    gameManager->AddScene(std::make_shared<AquariumGameScene>(
-        std::move(player), std::move(myAquarium), GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)
-    )); // player and aquarium are owned by the scene moving forward
+    auto aquariumScene = std::make_shared<AquariumGameScene>(
+        player, myAquarium, GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)
+    ); // player and aquarium are owned by the scene moving forward
+    aquariumScene->GetCamera().setViewport(ofGetWindowWidth(), ofGetWindowHeight(), ofGetWindowHeight() / float(VIEW_HEIGHT));
+    gameManager->AddScene(aquariumScene);
+
+    // everyone else starts beside the first player, tinted so they can be told apart
+    const ofColor tints[] = {ofColor::white, ofColor::orange, ofColor::cyan, ofColor::magenta, ofColor::yellow};
+    for(int p = 1; p < playerCount; ++p){
+        auto other = MakeTracked<MemorySubsystem::CREATURES, PlayerCreature>(worldWidth/2 - 50 + p * 120, worldHeight/2 - 50, DEFAULT_SPEED, this->spriteManager->GetSprite(AquariumCreatureType::NPCreature));
+        other->setDirection(0, 0);
+        other->setTint(tints[p % 5]);
+        aquariumScene->AddPlayer(other, GetLocalPlayerKeys(p));
+    }
+    if(inputPort > 0){
+        remoteInput.Open(inputPort);
+    }
+    if(connectPort > 0){
+        auto remoteScene = std::make_shared<SnapshotViewScene>(GameSceneKindToString(GameSceneKind::REMOTE_VIEW), spriteManager, connectPort);
+        remoteScene->GetCamera().setViewport(ofGetWindowWidth(), ofGetWindowHeight(), ofGetWindowHeight() / float(VIEW_HEIGHT));
+        gameManager->AddScene(remoteScene);
+    }
+
+    // a replay has to spawn the same fish the recording saw, so the seed comes from the file
+    unsigned seed = std::random_device{}();
+    if(!inputReplayPath.empty()){
+        aquariumScene->GetInput().LoadReplay(inputReplayPath, seed);
+    } else if(!inputRecordPath.empty()){
+        aquariumScene->GetInput().StartRecording(seed);
+    }
+    SeedCreatureRandom(seed);
+    myAquarium->Repopulate(); // initial population
 
     // Load font for game over message
     gameOverTitle.load("Verdana.ttf", 12, true, true);
@@ -65,15 +103,28 @@ void ofApp::setup(){
 
     gameManager->AddScene(std::make_shared<GameOverScene>(
         GameSceneKindToString(GameSceneKind::GAME_OVER),
-        std::make_shared<GameSprite>("game-over.png", ofGetWindowWidth(), ofGetWindowHeight())
+        MakeTracked<MemorySubsystem::SPRITES, GameSprite>("game-over.png", ofGetWindowWidth(), ofGetWindowHeight())
     ));
 
     ofSetLogLevel(OF_LOG_NOTICE); // Set default log level
+
+    if(!metricsPath.empty()){
+        telemetry.Start(metricsPath, 5.0f);
+    }
+    if(!framesPath.empty()){
+        framePacing.Start();
+    }
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
-    
+    framePacing.BeginUpdate();
+    UpdateBreakdown parts;
+    updateScenes(parts);
+    framePacing.EndUpdate(parts);
+}
+
+void ofApp::updateScenes(UpdateBreakdown& parts){
     if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::GAME_OVER)){
         return; // Stop updating if game is over or exiting
     }
@@ -83,29 +134,64 @@ void ofApp::update(){
         //set sound effects
         gameScene->SetCollisionSound(&bounceSound);
         gameScene->SetEatSound(&munchSound);
-        gameScene->Update();
+        remoteInput.Poll(gameScene->GetInput());
+        auto tickStart = std::chrono::steady_clock::now();
+        // the game's pace is two ticks a frame, both go into the breakdown
+        for(int t = 0; t < kAquariumTicksPerFrame; ++t){
+            gameScene->Update();
+            const UpdateBreakdown& tick = gameScene->GetLastUpdateTimings();
+            parts.streamingUs += tick.streamingUs;
+            parts.collisionsUs += tick.collisionsUs;
+            parts.simulationUs += tick.simulationUs;
+            if(gameScene->GetLastEvent() != nullptr && gameScene->GetLastEvent()->isGameOver()) break;
+        }
+        telemetry.RecordTick(*gameScene->GetAquarium(),
+            std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - tickStart).count());
         if(gameScene->GetLastEvent() != nullptr && gameScene->GetLastEvent()->isGameOver()){
             gameManager->Transition(GameSceneKindToString(GameSceneKind::GAME_OVER));
-            return;
         }
-        
+        return; // the aquarium is not handed to the manager, that would tick it once more
     }
 
     gameManager->UpdateActiveScene();
-    
-
-
 }
 
 //--------------------------------------------------------------
 void ofApp::draw(){
-    backgroundImage.draw(0, 0);
+    framePacing.BeginDraw();
+    auto drawStart = std::chrono::steady_clock::now();
+    // the intro and game over screens cover the whole window, no point painting under them
+    if(!gameManager->IsActiveSceneOpaque()){
+        backgroundLayer.draw(ofGetWindowWidth(), ofGetWindowHeight());
+    }
     gameManager->DrawActiveScene();
+    if(showMemoryOverlay){
+        // the numbers move slowly, rebuilding the text twice a second is plenty
+        if(--memoryOverlayCountdown <= 0){
+            memoryOverlayCountdown = 30;
+            std::ostringstream report;
+            MemoryLedger::WriteReport(report);
+            memoryOverlayText = report.str();
+        }
+        ofDrawBitmapString(memoryOverlayText, 20, ofGetWindowHeight() - 110);
+    }
+    telemetry.RecordDraw(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - drawStart).count());
+    framePacing.EndDraw();
 }
 
 //--------------------------------------------------------------
 void ofApp::exit(){
-    
+    telemetry.Stop(); // writes the last window before the scenes go away
+    if(framePacing.IsRecording()){
+        framePacing.Save(framesPath);
+    }
+    auto aquariumScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetScene(GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)));
+    InputQueue& input = aquariumScene->GetInput();
+    if(input.IsRecording()){
+        input.SaveRecording(inputRecordPath);
+    }
+    ofLogNotice() << "input latency over " << input.GetDrainedCount() << " events: mean "
+                  << input.GetMeanLatencyUs() / 1000.0 << " ms, max " << input.GetMaxLatencyUs() / 1000.0 << " ms" << std::endl;
 }
 
 //--------------------------------------------------------------
@@ -116,32 +202,44 @@ void ofApp::keyPressed(int key){
     }
     if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)){
         auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetActiveScene());
+        if(gameScene->IsPlayerKey(key)){
+            // movement waits for the next simulation tick
+            gameScene->GetInput().Push(key, InputAction::PRESS);
+            return;
+        }
         switch(key){
-            case OF_KEY_UP:
-                gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, -1);
+            case 'b':
+                // swap broadphase at runtime to compare them in game
+                gameScene->GetAquarium()->setBroadphase(
+                    gameScene->GetAquarium()->getBroadphase().GetKind() == BroadphaseKind::BRUTE_FORCE
+                    ? BroadphaseKind::SWEEP_AND_PRUNE : BroadphaseKind::BRUTE_FORCE);
                 break;
-                case OF_KEY_DOWN:
-                gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, 1);
+            case 's':
+                gameScene->GetAquarium()->setSchoolingEnabled(!gameScene->GetAquarium()->isSchoolingEnabled());
                 break;
-            case OF_KEY_LEFT:
-                gameScene->GetPlayer()->setDirection(-1, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-                gameScene->GetPlayer()->setFlipped(true);
+            case 'e':
+                // food web on top of the player's own hunting
+                gameScene->GetAquarium()->setEcosystemEnabled(!gameScene->GetAquarium()->isEcosystemEnabled());
                 break;
-                case OF_KEY_RIGHT:
-                gameScene->GetPlayer()->setDirection(1, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-                gameScene->GetPlayer()->setFlipped(false);
+            case 'm':
+                showMemoryOverlay = !showMemoryOverlay;
+                memoryOverlayCountdown = 0;
                 break;
             default:
                 break;
         }
-    
-        
-    
-        gameScene->GetPlayer()->move();
         return;
 
     }
 
+    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::REMOTE_VIEW)){
+        auto remoteScene = std::static_pointer_cast<SnapshotViewScene>(gameManager->GetActiveScene());
+        if(GetLocalPlayerKeys(0).owns(key)){
+            remoteScene->SendKey(key, InputAction::PRESS);
+        }
+        return;
+    }
+
     if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::GAME_INTRO)){
         switch (key)
         {
@@ -149,7 +247,7 @@ void ofApp::keyPressed(int key){
             if(!music.isPlaying()){
                 music.play();
             }
-            gameManager->Transition(GameSceneKindToString(GameSceneKind::AQUARIUM_GAME));
+            gameManager->Transition(GameSceneKindToString(connectPort > 0 ? GameSceneKind::REMOTE_VIEW : GameSceneKind::AQUARIUM_GAME));
             break;
         
         default:
@@ -166,18 +264,12 @@ void ofApp::keyPressed(int key){
 void ofApp::keyReleased(int key){
     if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)){
         auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetActiveScene());
-    if( key == OF_KEY_UP || key == OF_KEY_DOWN){
-        gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, 0);
-        gameScene->GetPlayer()->move();
-        return;
-    }
-    
-    if(key == OF_KEY_LEFT || key == OF_KEY_RIGHT){
-        gameScene->GetPlayer()->setDirection(0, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-        gameScene->GetPlayer()->move();
-        return;
+        if(gameScene->IsPlayerKey(key)){
+            gameScene->GetInput().Push(key, InputAction::RELEASE);
+        }
     }
-
+    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::REMOTE_VIEW) && GetLocalPlayerKeys(0).owns(key)){
+        std::static_pointer_cast<SnapshotViewScene>(gameManager->GetActiveScene())->SendKey(key, InputAction::RELEASE);
     }
 }
 
@@ -218,11 +310,16 @@ void ofApp::mouseExited(int x, int y){
 
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h){
-    backgroundImage.resize(w, h);
+    // the world stays as it is, only how it maps to the window changes
+    // the cached layers repaint at the new size on their next draw
+    backgroundLayer.invalidate();
+    gameManager->InvalidateScenes();
     auto aquariumScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetScene(GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)));
-    aquariumScene->GetAquarium()->setBounds(w,h);
-    aquariumScene->GetPlayer()->setBounds(w - 20, h - 20);
-
+    aquariumScene->GetCamera().setViewport(w, h, h / float(VIEW_HEIGHT));
+    if(connectPort > 0){
+        auto remoteScene = std::static_pointer_cast<SnapshotViewScene>(gameManager->GetScene(GameSceneKindToString(GameSceneKind::REMOTE_VIEW)));
+        remoteScene->GetCamera().setViewport(w, h, h / float(VIEW_HEIGHT));
+    }
 }
 
 //--------------------------------------------------------------
@@ -2,6 +2,9 @@
 
 #include "ofMain.h"
 #include "Aquarium.h"
+#include "AquariumTelemetry.h"
+#include "RemoteInput.h"
+#include "SnapshotNet.h"
 
 
 class ofApp : public ofBaseApp{
@@ -24,10 +27,26 @@ class ofApp : public ofBaseApp{
 		void windowResized(int w, int h) override;
 		void dragEvent(ofDragInfo dragInfo) override;
 		void gotMessage(ofMessage msg) override;
+
+		// the game part of update(), parts says where the aquarium's tick went
+		void updateScenes(UpdateBreakdown& parts);
 	
 		
 		char moveDirection;
 		int DEFAULT_SPEED = 5;
+		// world units the window shows at any size, more pixels just zoom in
+		int VIEW_WIDTH = 1024;
+		int VIEW_HEIGHT = 768;
+		int WORLD_SCALE = 2; // tank size in views along each axis
+
+		// set from the command line before setup runs
+		std::string inputRecordPath;
+		std::string inputReplayPath;
+		std::string metricsPath; // empty keeps the exporter off
+		std::string framesPath; // empty keeps the frame pacing recorder off
+		int playerCount = 1;
+		int inputPort = 0; // 0 keeps remote input off
+		int connectPort = 0; // set, space on the intro goes to a --serve game instead
 
 
 		AwaitFrames acuariumUpdate{5};
@@ -37,12 +56,22 @@ class ofApp : public ofBaseApp{
 
 
 		ofImage backgroundImage;
+		CachedLayer backgroundLayer{[this](int w, int h){ backgroundImage.draw(0, 0, w, h); }};
 		//Background music
 		ofSoundPlayer music;
 		//Sound effects
 		ofSoundPlayer bounceSound;
 		ofSoundPlayer munchSound;
 
+		AquariumTelemetry telemetry;
+		FramePacingRecorder framePacing;
+		RemoteInputServer remoteInput;
+
+		// 'm' shows where the memory goes, by subsystem
+		bool showMemoryOverlay = false;
+		int memoryOverlayCountdown = 0;
+		std::string memoryOverlayText;
+
 		std::unique_ptr<GameSceneManager> gameManager;
 		std::shared_ptr<AquariumSpriteManager>spriteManager;
 		